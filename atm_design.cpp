@@ -6,6 +6,7 @@ ATM machine design pattern using state design pattern and chain of responsibilit
 *******************************************************************************/
 #include <iostream>
 #include <algorithm>
+#include "metrics.h"
 using namespace std;
 
 /* ================================
@@ -322,14 +323,27 @@ CashWithdrawalState::CashWithdrawalState() {
 }
 
 void CashWithdrawalState::cashWithdrawal(ATM* atm, Card* card, int amount) {
+    static metrics::Histogram& latency = metrics::Registry::global().histogram(
+        "atm_withdrawal_latency_seconds", "CashWithdrawalState::cashWithdrawal latency");
+    static metrics::Counter& atmShort = metrics::Registry::global().counter(
+        "atm_withdrawals_total", "cash withdrawals by outcome", "outcome=\"atm_insufficient_funds\"");
+    static metrics::Counter& bankShort = metrics::Registry::global().counter(
+        "atm_withdrawals_total", "cash withdrawals by outcome", "outcome=\"bank_insufficient_funds\"");
+    static metrics::Counter& dispensed = metrics::Registry::global().counter(
+        "atm_withdrawals_total", "cash withdrawals by outcome", "outcome=\"success\"");
+    static metrics::Counter& amountDispensed = metrics::Registry::global().counter(
+        "atm_withdrawn_amount_total", "cash handed out by successful withdrawals");
+    metrics::ScopedTimer timer(latency);
 
     if (atm->getAtmBalance() < amount) {
+        atmShort.inc();
         cout << "ATM Insufficient Funds\n";
         exit(atm);
         return;
     }
 
     if (card->getBankBalance() < amount) {
+        bankShort.inc();
         cout << "Bank Insufficient Funds\n";
         exit(atm);
         return;
@@ -344,6 +358,8 @@ void CashWithdrawalState::cashWithdrawal(ATM* atm, Card* card, int amount) {
 
     processor->withdraw(atm, amount);
 
+    dispensed.inc();
+    amountDispensed.inc(amount);
     cout << "Withdrawal Successful\n";
     exit(atm);
 }
@@ -375,6 +391,8 @@ void CheckBalanceState::returnCard() {
    MAIN
 ================================ */
 
+// benchmarks/ include this file for its classes and supply their own main
+#ifndef LLD_NO_MAIN
 int main() {
 
     ATM atm(3500, 1, 2, 5);
@@ -391,5 +409,8 @@ int main() {
 
     atm.printCurrentATMStatus();
 
+    cout << metrics::Registry::global().prometheusText();
+
     return 0;
 }
+#endif
@@ -0,0 +1,47 @@
+// full withdrawal sessions through the ATM state machine (atm_design.cpp)
+#define LLD_NO_MAIN
+#include "../atm_design.cpp"
+#include "harness.h"
+
+int main(int argc, char** argv) {
+    bench::Suite suite("atm", bench::parseOptions(argc, argv));
+
+    // insert card, PIN, select, withdraw: the ATM narrates each step, so
+    // cout is silenced while timing
+    suite.add("withdrawal/session", [](uint64_t seed) {
+        auto amounts = make_shared<vector<int>>();
+        mt19937_64 rng(seed);
+        for (int i = 0; i < 50000; i++) amounts->push_back(100 * (1 + rng() % 60));
+        return bench::Body([amounts]() {
+            ATM atm(2000000000, 1000000, 1000000, 1000000);
+            UserBankAccount account(2000000000);
+            Card card(112211, &account);
+            bench::QuietCout quiet;
+            for (int amount : *amounts) {
+                atm.getCurrentATMState()->insertCard(&atm, &card);
+                atm.getCurrentATMState()->authenticatePin(&atm, &card, 112211);
+                atm.getCurrentATMState()->selectOperation(&atm, &card, OperationType::WITHDRAW);
+                atm.getCurrentATMState()->cashWithdrawal(&atm, &card, amount);
+            }
+            return (uint64_t)amounts->size();
+        });
+    });
+
+    // the note dispensing chain on its own
+    suite.add("withdrawal/dispense-chain", [](uint64_t seed) {
+        auto amounts = make_shared<vector<int>>();
+        mt19937_64 rng(seed);
+        for (int i = 0; i < 200000; i++) amounts->push_back(100 * (1 + rng() % 60));
+        return bench::Body([amounts]() {
+            ATM atm(2000000000, 10000000, 10000000, 10000000);
+            OneHundredWithdrawProcessor hundreds(nullptr);
+            FiveHundredWithdrawProcessor fiveHundreds(&hundreds);
+            TwoThousandWithdrawProcessor chain(&fiveHundreds);
+            for (int amount : *amounts) chain.withdraw(&atm, amount);
+            bench::doNotOptimize(atm.getAtmBalance());
+            return (uint64_t)amounts->size();
+        });
+    });
+
+    return suite.run();
+}
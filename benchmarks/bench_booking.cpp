@@ -0,0 +1,101 @@
+// seat locking, booking and browse queries (bookMyShow.cpp)
+#define LLD_NO_MAIN
+#include "../bookMyShow.cpp"
+#include "harness.h"
+
+static vector<Seat> makeSeats(int count) {
+    vector<Seat> seats;
+    for (int i = 1; i <= count; i++) seats.emplace_back(i, i % 5 ? SeatCategory::NORMAL : SeatCategory::PREMIUM);
+    return seats;
+}
+
+// groups of 1-4 seats a customer would pick, drawn from the seed
+static vector<vector<int>> seatRequests(uint64_t seed, int count, int seats) {
+    mt19937_64 rng(seed);
+    vector<vector<int>> requests(count);
+    for (auto& request : requests) {
+        int first = 1 + rng() % seats, size = 1 + rng() % 4;
+        for (int i = 0; i < size && first + i <= seats; i++) request.push_back(first + i);
+    }
+    return requests;
+}
+
+int main(int argc, char** argv) {
+    bench::Suite suite("booking", bench::parseOptions(argc, argv));
+
+    // lock then release, so later requests keep finding free seats
+    suite.add("lockSeats/release", [](uint64_t seed) {
+        auto movie = make_shared<Movie>("Avengers");
+        auto show = make_shared<Show>(movie.get(), "2026-02-10", "10:00", makeSeats(300));
+        auto requests = make_shared<vector<vector<int>>>(seatRequests(seed, 200000, 300));
+        return bench::Body([movie, show, requests]() {
+            for (auto& request : *requests) {
+                if (show->lockSeats(request)) show->releaseSeats(request);
+            }
+            return (uint64_t)requests->size();
+        });
+    });
+
+    // sells out a 300 seat show; later requests hit taken seats and throw
+    suite.add("book/sell-out", [](uint64_t seed) {
+        auto movie = make_shared<Movie>("Avengers");
+        auto show = make_shared<Show>(movie.get(), "2026-02-10", "10:00", makeSeats(300));
+        auto requests = make_shared<vector<vector<int>>>(seatRequests(seed, 2000, 300));
+        return bench::Body([movie, show, requests]() {
+            BookingService service;
+            User user("U1", "bench");
+            for (auto& request : *requests) {
+                try {
+                    bench::doNotOptimize(service.book(&user, show.get(), request));
+                } catch (const runtime_error&) {
+                }
+            }
+            return (uint64_t)requests->size();
+        });
+    });
+
+    // 50 theatres x 4 screens, 8 movies, 4 shows per screen per day
+    suite.add("browse/movies+theatres+shows", [](uint64_t seed) {
+        struct City {
+            vector<unique_ptr<Movie>> movies;
+            vector<unique_ptr<Show>> shows;
+            vector<unique_ptr<Screen>> screens;
+            vector<unique_ptr<Theatre>> theatres;
+            TheatreController controller;
+        };
+        auto city = make_shared<City>();
+        mt19937_64 rng(seed);
+        vector<Seat> seats = makeSeats(100);
+        for (int m = 0; m < 8; m++) city->movies.push_back(make_unique<Movie>("movie_" + to_string(m)));
+        for (int t = 0; t < 50; t++) {
+            vector<Screen*> screens;
+            for (int s = 0; s < 4; s++) {
+                city->screens.push_back(make_unique<Screen>(s, seats));
+                for (int slot = 0; slot < 4; slot++) {
+                    for (const char* date : {"2026-02-10", "2026-02-11"}) {
+                        Movie* movie = city->movies[rng() % city->movies.size()].get();
+                        city->shows.push_back(make_unique<Show>(movie, date, to_string(10 + 3 * slot) + ":00", seats));
+                        city->screens.back()->addShow(city->shows.back().get());
+                    }
+                }
+                screens.push_back(city->screens.back().get());
+            }
+            city->theatres.push_back(make_unique<Theatre>("theatre_" + to_string(t), CITY::BENGALURU, screens));
+            city->controller.addTheatre(city->theatres.back().get());
+        }
+        return bench::Body([city]() {
+            const int queries = 200;
+            for (int q = 0; q < queries; q++) {
+                string movie = "movie_" + to_string(q % 8);
+                bench::doNotOptimize(city->controller.getMovies(CITY::BENGALURU, "2026-02-10"));
+                auto theatres = city->controller.getTheatres(CITY::BENGALURU, movie, "2026-02-10");
+                for (Theatre* theatre : theatres) {
+                    bench::doNotOptimize(city->controller.getShows(theatre, movie, "2026-02-10"));
+                }
+            }
+            return (uint64_t)queries;
+        });
+    });
+
+    return suite.run();
+}
@@ -0,0 +1,60 @@
+// directory tree building and traversal (file_directory.cpp)
+#define LLD_NO_MAIN
+#include "../file_directory.cpp"
+#include "harness.h"
+
+static const size_t BENCH_NODES = 200000;
+
+// built once and shared by every case: the tree has no seed-dependent
+// shape and Directory never frees its children
+static Directory* sharedTree() {
+    static Directory* root = buildBenchTree(BENCH_NODES, 32);
+    return root;
+}
+
+int main(int argc, char** argv) {
+    bench::Suite suite("directory", bench::parseOptions(argc, argv));
+
+    for (int threads : {1, 4}) {
+        suite.add("walk/aggregate-" + to_string(threads) + "t", [threads](uint64_t) {
+            Directory* root = sharedTree();
+            return bench::Body([root, threads]() {
+                ParallelTreeWalker walker(threads);
+                bench::doNotOptimize(walker.aggregate(root).bytes);
+                return (uint64_t)BENCH_NODES;
+            });
+        });
+    }
+
+    suite.add("lookup/resolve-path", [](uint64_t seed) {
+        Directory* root = sharedTree();
+        auto paths = make_shared<vector<string>>();
+        mt19937_64 rng(seed);
+        size_t directories = benchDirectoryCount(BENCH_NODES, 32);
+        for (int i = 0; i < 100000; i++) {
+            // walk up from a random node to build its path
+            size_t node = 1 + rng() % (BENCH_NODES - 1);
+            string path;
+            for (size_t n = node; n != 0; n = (n - 1) / 32) path = "/" + benchNodeName(n, directories) + path;
+            paths->push_back(path.substr(1));
+        }
+        return bench::Body([root, paths]() {
+            size_t found = 0;
+            for (auto& path : *paths) found += root->resolve(path) != nullptr;
+            if (found != paths->size()) throw runtime_error("resolve missed a generated path");
+            return (uint64_t)paths->size();
+        });
+    });
+
+    suite.add("export/json-lines", [](uint64_t) {
+        Directory* root = sharedTree();
+        return bench::Body([root]() {
+            ofstream devNull("/dev/null");
+            TreeExporter exporter(devNull, 1 << 16);
+            exporter.write(root, TreeExporter::JSON_LINES);
+            return (uint64_t)BENCH_NODES;
+        });
+    });
+
+    return suite.run();
+}
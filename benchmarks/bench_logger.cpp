@@ -0,0 +1,60 @@
+// logger throughput (chainOfResponsibility.cpp)
+#define LLD_NO_MAIN
+#include "../chainOfResponsibility.cpp"
+#include "harness.h"
+
+static const char* const BENCH_LOG = "bench_logger.log";
+
+int main(int argc, char** argv) {
+    bench::Suite suite("logger", bench::parseOptions(argc, argv));
+
+    // below the dispatcher threshold: the message is never built
+    suite.add("dispatcher/filtered-debug", [](uint64_t) {
+        auto dispatcher = make_shared<LogDispatcher>(buildLoggerChain(), ERROR);
+        return bench::Body([dispatcher]() {
+            const int records = 1000000;
+            for (int i = 0; i < records; i++) LOG_DEBUG(*dispatcher, "seat " + to_string(i));
+            return (uint64_t)records;
+        });
+    });
+
+    // chain of FileLoggers into a FileSink, flushed at the end of the run
+    suite.add("file-sink/records", [](uint64_t) {
+        return bench::Body([]() {
+            const int records = 300000;
+            {
+                FileSinkConfig config;
+                config.path = BENCH_LOG;
+                FileSink sink(config);
+                Logger* chain = buildFileLoggerChain(&sink);
+                for (int i = 0; i < records; i++) chain->logMessage(INFO, "booking 42 confirmed for seat 17");
+                sink.flush();
+            }
+            remove(BENCH_LOG);
+            return (uint64_t)records;
+        });
+    });
+
+    // producers enqueue, the backend thread formats into a FileSink;
+    // timed until the queue is drained
+    suite.add("async/enqueue+drain", [](uint64_t) {
+        return bench::Body([]() {
+            const int records = 300000;
+            {
+                FileSinkConfig config;
+                config.path = BENCH_LOG;
+                FileSink sink(config);
+                AsyncLogger logger(buildFileLoggerChain(&sink), 1 << 14, OverflowPolicy::BLOCK);
+                for (int i = 0; i < records; i++) {
+                    logger.logFormat(INFO, LOG_FORMAT_ID("booking {} confirmed for seat {}"), i, 17);
+                }
+                logger.shutdown();
+                sink.flush();
+            }
+            remove(BENCH_LOG);
+            return (uint64_t)records;
+        });
+    });
+
+    return suite.run();
+}
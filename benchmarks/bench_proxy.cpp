@@ -0,0 +1,83 @@
+// keyed reads through the proxies (proxyDesignPattern.cpp)
+#define LLD_NO_MAIN
+#include "../proxyDesignPattern.cpp"
+#include "harness.h"
+
+// zipf(1.0) over `keys` keys, same distribution as runCacheBenchmark
+static shared_ptr<vector<string>> zipfKeys(uint64_t seed, int reads, int keys) {
+    vector<double> cdf(keys);
+    double total = 0;
+    for (int i = 0; i < keys; i++) cdf[i] = (total += 1.0 / (i + 1));
+    for (auto& c : cdf) c /= total;
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> uniform(0, 1);
+    auto out = make_shared<vector<string>>();
+    for (int i = 0; i < reads; i++) {
+        out->push_back("user:" + to_string(lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()));
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    bench::Suite suite("proxy", bench::parseOptions(argc, argv));
+
+    // zero-latency backend: the cached/direct gap is what the proxy costs per read
+    suite.add("read/direct-0us", [](uint64_t seed) {
+        auto keys = zipfKeys(seed, 200000, 10000);
+        auto backend = make_shared<SimulatedDatabase>(chrono::microseconds(0));
+        return bench::Body([keys, backend]() {
+            for (auto& key : *keys) bench::doNotOptimize(backend->readData(key));
+            return (uint64_t)keys->size();
+        });
+    });
+
+    suite.add("read/cached-0us", [](uint64_t seed) {
+        auto keys = zipfKeys(seed, 200000, 10000);
+        return bench::Body([keys]() {
+            SimulatedDatabase backend(chrono::microseconds(0));
+            CacheConfig config;
+            config.capacity = 2000;
+            CachingDatabaseProxy cache(&backend, config);
+            for (auto& key : *keys) bench::doNotOptimize(cache.readData(key));
+            return (uint64_t)keys->size();
+        });
+    });
+
+    // 50us backend: the hit rate decides the per-read cost; each run starts
+    // with a cold cache
+    suite.add("read/direct-50us", [](uint64_t seed) {
+        auto keys = zipfKeys(seed, 2000, 10000);
+        auto backend = make_shared<SimulatedDatabase>(chrono::microseconds(50));
+        return bench::Body([keys, backend]() {
+            for (auto& key : *keys) bench::doNotOptimize(backend->readData(key));
+            return (uint64_t)keys->size();
+        });
+    });
+
+    suite.add("read/cached-50us", [](uint64_t seed) {
+        auto keys = zipfKeys(seed, 2000, 10000);
+        return bench::Body([keys]() {
+            SimulatedDatabase backend(chrono::microseconds(50));
+            CacheConfig config;
+            config.capacity = 2000;
+            CachingDatabaseProxy cache(&backend, config);
+            for (auto& key : *keys) bench::doNotOptimize(cache.readData(key));
+            return (uint64_t)keys->size();
+        });
+    });
+
+    suite.add("read/authorized", [](uint64_t) {
+        auto backend = make_shared<LatencyDatabase>(chrono::microseconds(0));
+        auto engine = make_shared<AuthorizationEngine>();
+        auto principal = make_shared<Principal>("p", vector<string>{"user", "admin"});
+        auto proxy = make_shared<AuthorizedDatabaseProxy>(backend.get(), principal.get(), engine.get());
+        engine->reload({{"admin", {"read"}}});
+        return bench::Body([backend, engine, principal, proxy]() {
+            const int reads = 1000000;
+            for (int i = 0; i < reads; i++) proxy->readData();
+            return (uint64_t)reads;
+        });
+    });
+
+    return suite.run();
+}
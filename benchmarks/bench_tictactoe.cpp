@@ -0,0 +1,82 @@
+// move checks and search (tictactoe.cpp)
+#define LLD_NO_MAIN
+#include "../tictactoe.cpp"
+#include "harness.h"
+
+using MoveList = vector<pair<int, int>>;
+
+// shuffled cells, as in runWinCheckBenchmark
+static shared_ptr<vector<MoveList>> randomGames(uint64_t seed, int size, int count) {
+    mt19937_64 rng(seed);
+    auto games = make_shared<vector<MoveList>>(count);
+    for (auto& game : *games) {
+        for (int r = 0; r < size; r++)
+            for (int c = 0; c < size; c++) game.push_back({r, c});
+        shuffle(game.begin(), game.end(), rng);
+    }
+    return games;
+}
+
+// place + checkWinner until someone wins; board setup is timed too, it is
+// small next to a game
+static uint64_t playGames(int size, WinningStrategy& strategy, const vector<MoveList>& games) {
+    uint64_t moves = 0;
+    for (auto& game : games) {
+        Board board(size);
+        strategy.reset();
+        for (size_t m = 0; m < game.size(); m++) {
+            Symbol symbol = m % 2 == 0 ? Symbol::X : Symbol::O;
+            board.place(game[m].first, game[m].second, symbol);
+            moves++;
+            if (strategy.checkWinner(board, symbol, game[m].first, game[m].second)) break;
+        }
+    }
+    return moves;
+}
+
+int main(int argc, char** argv) {
+    bench::Suite suite("tictactoe", bench::parseOptions(argc, argv));
+
+    for (int size : {3, 19}) {
+        int count = size == 3 ? 20000 : 200;
+        string board = to_string(size) + "x" + to_string(size);
+        suite.add("check/rescan-" + board, [size, count](uint64_t seed) {
+            auto games = randomGames(seed, size, count);
+            return bench::Body([size, games]() {
+                NXNWinningstrategy strategy;
+                return playGames(size, strategy, *games);
+            });
+        });
+        suite.add("check/counters-" + board, [size, count](uint64_t seed) {
+            auto games = randomGames(seed, size, count);
+            return bench::Body([size, games]() {
+                CounterWinningStrategy strategy;
+                return playGames(size, strategy, *games);
+            });
+        });
+        suite.add("check/k-in-a-row-" + board, [size, count](uint64_t seed) {
+            auto games = randomGames(seed, size, count);
+            int k = size == 3 ? 3 : 5;
+            return bench::Body([size, k, games]() {
+                KInARowWinningStrategy strategy(k);
+                return playGames(size, strategy, *games);
+            });
+        });
+    }
+
+    // single-threaded search to a fixed depth on the runSearchBenchmark
+    // position; reported per node, the node count itself is deterministic
+    suite.add("search/15x15-depth4", [](uint64_t) {
+        auto position = make_shared<Board>(15);
+        int stones[][3] = {{7, 7, 0}, {7, 8, 1}, {8, 8, 0}, {6, 6, 1}, {8, 7, 0}, {9, 6, 1}, {6, 8, 0}, {8, 9, 1}};
+        for (auto& stone : stones) position->place(stone[0], stone[1], stone[2] == 0 ? Symbol::X : Symbol::O);
+        return bench::Body([position]() {
+            SearchEngine engine(5);
+            SearchLimits limits{chrono::milliseconds(60000)};
+            limits.maxDepth = 4;
+            return engine.search(*position, Symbol::X, limits).nodes;
+        });
+    });
+
+    return suite.run();
+}
@@ -0,0 +1,50 @@
+// signal stepping (traffic_signal.cpp)
+#define LLD_NO_MAIN
+#include "../traffic_signal.cpp"
+#include "harness.h"
+
+static const uint32_t BENCH_SIGNALS = 10000;
+
+int main(int argc, char** argv) {
+    bench::Suite suite("traffic", bench::parseOptions(argc, argv));
+
+    // fixed-step sweep, every signal every simulated second
+    suite.add("step/bank-tick", [](uint64_t seed) {
+        mt19937 rng((uint32_t)seed);
+        auto bank = make_shared<SignalBank>();
+        for (uint32_t i = 0; i < BENCH_SIGNALS; i++) bank->add(randomTiming(rng));
+        return bench::Body([bank]() {
+            const uint32_t seconds = 200;
+            bank->tick(seconds);
+            return (uint64_t)BENCH_SIGNALS * seconds;
+        });
+    });
+
+    // event-driven: one simulated hour per run, reported per phase change
+    suite.add("step/timer-wheel-events", [](uint64_t seed) {
+        mt19937 rng((uint32_t)seed);
+        auto simulation = make_shared<SignalSimulation>();
+        for (uint32_t i = 0; i < BENCH_SIGNALS; i++) simulation->addSignal(randomTiming(rng));
+        return bench::Body([simulation]() {
+            uint64_t before = simulation->eventsProcessed();
+            simulation->runUntil(simulation->now() + 3600);
+            return simulation->eventsProcessed() - before;
+        });
+    });
+
+    // the classic state-pattern API over bank slots, announcements off
+    suite.add("step/facade-request", [](uint64_t seed) {
+        mt19937 rng((uint32_t)seed);
+        auto bank = make_shared<SignalBank>();
+        for (uint32_t i = 0; i < BENCH_SIGNALS; i++) bank->add(randomTiming(rng));
+        return bench::Body([bank]() {
+            const uint32_t rounds = 50;
+            for (uint32_t round = 0; round < rounds; round++) {
+                for (uint32_t i = 0; i < BENCH_SIGNALS; i++) TrafficSignal(*bank, i).request();
+            }
+            return (uint64_t)BENCH_SIGNALS * rounds;
+        });
+    });
+
+    return suite.run();
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+
+benchmark harness shared by benchmarks/bench_*.cpp
+
+a case is a setup function that gets the run's seed and returns the timed
+body; the body does a fixed amount of work and returns how many operations
+it performed. every run (warmup included) calls setup again with the same
+seed, so each run times exactly the same workload and setup cost is never
+timed. statistics are over the per-operation time of the measured runs.
+
+    ./bench_x [--runs N] [--warmup N] [--seed S] [--filter substring]
+              [--json path] [--label text]
+
+*******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+struct Options {
+    int warmup = 2;
+    int runs = 10;
+    uint64_t seed = 42;
+    std::string filter;
+    std::string jsonPath;
+    std::string label;      // e.g. a commit id, copied into the JSON
+};
+
+inline Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "--runs") options.runs = std::max(1, std::stoi(value));
+        else if (flag == "--warmup") options.warmup = std::max(0, std::stoi(value));
+        else if (flag == "--seed") options.seed = std::stoull(value);
+        else if (flag == "--filter") options.filter = value;
+        else if (flag == "--json") options.jsonPath = value;
+        else if (flag == "--label") options.label = value;
+        else throw std::invalid_argument("unknown option " + flag);
+    }
+    return options;
+}
+
+struct Stats {
+    double median = 0;
+    double mad = 0;         // median absolute deviation
+    double mean = 0;
+    double min = 0;
+    double max = 0;
+    double p10 = 0;
+    double p90 = 0;
+    double p99 = 0;
+};
+
+// linear interpolation between closest ranks; sorted must not be empty
+inline double percentile(const std::vector<double>& sorted, double p) {
+    double rank = p * (sorted.size() - 1);
+    size_t low = (size_t)rank;
+    size_t high = std::min(low + 1, sorted.size() - 1);
+    return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+}
+
+inline Stats summarize(std::vector<double> samples) {
+    Stats stats;
+    std::sort(samples.begin(), samples.end());
+    stats.median = percentile(samples, 0.5);
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.p10 = percentile(samples, 0.10);
+    stats.p90 = percentile(samples, 0.90);
+    stats.p99 = percentile(samples, 0.99);
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    stats.mean = sum / samples.size();
+    std::vector<double> deviations;
+    for (double sample : samples) deviations.push_back(std::fabs(sample - stats.median));
+    std::sort(deviations.begin(), deviations.end());
+    stats.mad = percentile(deviations, 0.5);
+    return stats;
+}
+
+// swallows std::cout for its lifetime (state machines that narrate every step)
+class QuietCout {
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+    } null;
+    std::streambuf* previous;
+
+public:
+    QuietCout() : previous(std::cout.rdbuf(&null)) {}
+    ~QuietCout() { std::cout.rdbuf(previous); }
+};
+
+// keeps the optimizer from dropping work whose result is otherwise unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+using Body = std::function<uint64_t()>;
+using Setup = std::function<Body(uint64_t seed)>;
+
+struct Result {
+    std::string name;
+    uint64_t operations = 0;        // per run
+    std::vector<double> nanosPerOp;
+    Stats stats;
+};
+
+class Suite {
+    std::string module;
+    Options options;
+    std::vector<std::pair<std::string, Setup>> cases;
+
+    static std::string escape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results) const {
+        out << "{\n  \"module\": \"" << escape(module) << "\",\n";
+        out << "  \"label\": \"" << escape(options.label) << "\",\n";
+        out << "  \"compiler\": \"" << escape(__VERSION__) << "\",\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"seed\": " << options.seed << ",\n";
+        out << "  \"warmup_runs\": " << options.warmup << ",\n";
+        out << "  \"runs\": " << options.runs << ",\n";
+        out << "  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "    {\"name\": \"" << escape(r.name) << "\", \"operations_per_run\": " << r.operations
+                << ", \"median\": " << r.stats.median << ", \"mad\": " << r.stats.mad
+                << ", \"mean\": " << r.stats.mean << ", \"min\": " << r.stats.min << ", \"max\": " << r.stats.max
+                << ", \"p10\": " << r.stats.p10 << ", \"p90\": " << r.stats.p90 << ", \"p99\": " << r.stats.p99
+                << ", \"ops_per_second\": " << (r.stats.median > 0 ? 1e9 / r.stats.median : 0) << ", \"samples\": [";
+            for (size_t s = 0; s < r.nanosPerOp.size(); s++) out << (s ? ", " : "") << r.nanosPerOp[s];
+            out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+public:
+    Suite(std::string module, Options options) : module(std::move(module)), options(std::move(options)) {}
+
+    void add(const std::string& name, Setup setup) {
+        cases.push_back({name, std::move(setup)});
+    }
+
+    // table on stderr, JSON on stdout unless --json names a file
+    int run() {
+        std::vector<Result> results;
+        for (auto& [name, setup] : cases) {
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos) continue;
+            Result result;
+            result.name = name;
+            for (int i = 0; i < options.warmup + options.runs; i++) {
+                Body body = setup(options.seed);
+                auto start = std::chrono::steady_clock::now();
+                uint64_t operations = body();
+                double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                result.operations = operations;
+                if (i >= options.warmup) result.nanosPerOp.push_back(nanos / std::max<uint64_t>(operations, 1));
+            }
+            result.stats = summarize(result.nanosPerOp);
+            fprintf(stderr, "%-12s %-32s median %10.1f ns/op  mad %8.1f  p10 %10.1f  p90 %10.1f  (%llu ops/run)\n",
+                    module.c_str(), name.c_str(), result.stats.median, result.stats.mad, result.stats.p10,
+                    result.stats.p90, (unsigned long long)result.operations);
+            results.push_back(std::move(result));
+        }
+        if (options.jsonPath.empty()) {
+            writeJson(std::cout, results);
+        } else {
+            std::ofstream out(options.jsonPath);
+            writeJson(out, results);
+        }
+        return 0;
+    }
+};
+
+}  // namespace bench
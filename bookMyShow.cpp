@@ -16,6 +16,7 @@ Theatre
 #include <iostream>
 #include <bits/stdc++.h>
 #include <mutex>
+#include "metrics.h"
 using namespace std;
 
 class Show;
@@ -71,6 +72,77 @@ public:
 };
 
 
+class Show {
+    Movie* movie;
+    string showDate;
+    string showTime;
+
+    unordered_map<int, SeatStatus> seatStatus;
+    unordered_map<int, mutex> seatLocks;
+
+public:
+    Show(Movie* movie, string date, string time, const vector<Seat>& seats)
+        : movie(movie), showDate(date), showTime(time) {
+
+        // every seat's mutex exists up front, so lockSeats never inserts
+        for (const Seat& seat : seats) {
+            seatStatus[seat.getSeatId()] = SeatStatus::AVAILABLE;
+            seatLocks[seat.getSeatId()];
+        }
+    }
+
+    string getDate() const { return showDate; }
+    string getTime() const { return showTime; }
+    Movie* getMovie() const { return movie; }
+
+    bool lockSeats(vector<int> seatIds) {
+        static metrics::Counter& attempts = metrics::Registry::global().counter(
+            "booking_seat_lock_attempts_total", "Show::lockSeats calls");
+        static metrics::Counter& conflicts = metrics::Registry::global().counter(
+            "booking_seat_lock_conflicts_total", "Show::lockSeats calls that found a seat taken or unknown");
+        attempts.inc();
+
+        sort(seatIds.begin(), seatIds.end());
+        seatIds.erase(unique(seatIds.begin(), seatIds.end()), seatIds.end());
+        vector<unique_lock<mutex>> locks;
+
+        for (int seatId : seatIds) {
+            auto lock = seatLocks.find(seatId);
+            if (lock == seatLocks.end()) {
+                conflicts.inc();
+                return false;
+            }
+            locks.emplace_back(lock->second);
+        }
+
+        for (int seatId : seatIds) {
+            if (seatStatus[seatId] != SeatStatus::AVAILABLE) {
+                conflicts.inc();
+                return false;
+            }
+        }
+
+        for (int seatId : seatIds) {
+            seatStatus[seatId] = SeatStatus::LOCKED;
+        }
+
+        return true;
+    }
+
+    void confirmSeats(const vector<int>& seatIds) {
+        for (int seatId : seatIds) {
+            seatStatus[seatId] = SeatStatus::BOOKED;
+        }
+    }
+
+    void releaseSeats(const vector<int>& seatIds) {
+        for (int seatId : seatIds) {
+            seatStatus[seatId] = SeatStatus::AVAILABLE;
+        }
+    }
+};
+
+
 class Screen {
     int screenId;
     vector<Seat> seats;
@@ -173,73 +245,6 @@ enum class Status{
     LOCKED,
 };
 
-class Movie {
-    string name;
-
-public:
-    Movie(string name) : name(name) {}
-
-    string getName() const {
-        return name;
-    }
-};
-
-class Show {
-    Movie* movie;
-    string showDate;
-    string showTime;
-
-    unordered_map<int, SeatStatus> seatStatus;
-    unordered_map<int, mutex> seatLocks;
-
-public:
-    Show(Movie* movie, string date, string time, const vector<Seat>& seats)
-        : movie(movie), showDate(date), showTime(time) {
-
-        for (const Seat& seat : seats) {
-            seatStatus[seat.getSeatId()] = SeatStatus::AVAILABLE;
-        }
-    }
-
-    string getDate() const { return showDate; }
-    string getTime() const { return showTime; }
-    Movie* getMovie() const { return movie; }
-
-    bool lockSeats(vector<int> seatIds) {
-        sort(seatIds.begin(), seatIds.end());
-        vector<unique_lock<mutex>> locks;
-
-        for (int seatId : seatIds) {
-            locks.emplace_back(seatLocks[seatId]);
-        }
-
-        for (int seatId : seatIds) {
-            if (seatStatus[seatId] != SeatStatus::AVAILABLE)
-                return false;
-        }
-
-        for (int seatId : seatIds) {
-            seatStatus[seatId] = SeatStatus::LOCKED;
-        }
-
-        return true;
-    }
-
-    void confirmSeats(const vector<int>& seatIds) {
-        for (int seatId : seatIds) {
-            seatStatus[seatId] = SeatStatus::BOOKED;
-        }
-    }
-
-    void releaseSeats(const vector<int>& seatIds) {
-        for (int seatId : seatIds) {
-            seatStatus[seatId] = SeatStatus::AVAILABLE;
-        }
-    }
-};
-
-
-
 class TheatreController {
     TheatreService theatreService;
 
@@ -301,8 +306,18 @@ class BookingService {
 
 public:
     Booking* book(User* user, Show* show, vector<int> seats) {
+        static metrics::Histogram& latency = metrics::Registry::global().histogram(
+            "booking_book_latency_seconds", "BookingService::book latency, failures included");
+        static metrics::Counter& unavailable = metrics::Registry::global().counter(
+            "booking_book_total", "BookingService::book calls by outcome", "outcome=\"seats_unavailable\"");
+        static metrics::Counter& paymentFailed = metrics::Registry::global().counter(
+            "booking_book_total", "BookingService::book calls by outcome", "outcome=\"payment_failed\"");
+        static metrics::Counter& booked = metrics::Registry::global().counter(
+            "booking_book_total", "BookingService::book calls by outcome", "outcome=\"booked\"");
+        metrics::ScopedTimer timer(latency);
 
         if (!show->lockSeats(seats)) {
+            unavailable.inc();
             throw runtime_error("Seats unavailable");
         }
 
@@ -313,9 +328,11 @@ public:
 
             Booking* booking = new Booking(user, show, seats, payment);
             bookings[booking->getBookingId()] = booking;
+            booked.inc();
             return booking;
         } else {
             show->releaseSeats(seats);
+            paymentFailed.inc();
             throw runtime_error("Payment failed");
         }
     }
@@ -354,6 +371,8 @@ public:
 };
 
 
+// benchmarks/ include this file for its classes and supply their own main
+#ifndef LLD_NO_MAIN
 int main() {
 
     // ---------- 1️⃣ Create Movies ----------
@@ -460,5 +479,16 @@ int main() {
         cout << "\n❌ Booking Failed: " << e.what() << "\n";
     }
 
+    // same seats again: counted as a lock conflict
+    try {
+        bookingController.createBooking(&user, selectedShow, selectedSeats);
+    }
+    catch (exception& e) {
+        cout << "\n❌ Booking Failed: " << e.what() << "\n";
+    }
+
+    cout << "\n" << metrics::Registry::global().prometheusText();
+
     return 0;
 }
+#endif
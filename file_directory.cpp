@@ -6,14 +6,44 @@ File directory design using composite design pattern
 
 #include <iostream>
 #include <bits/stdc++.h>
+#include <malloc.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 using namespace std;
 
 
 
 
+class Directory;
+
+// bytes / files / newest mtime of everything at or below a node
+struct SubtreeStats{
+    uint64_t bytes = 0;
+    uint64_t fileCount = 0;
+    int64_t newestMtime = 0;
+};
+
 class FileSystemComponent{
+protected:
+    Directory* parent = nullptr;
+    friend class Directory;
 public:
     virtual void printContent()=0;
+    virtual const string& getName() const=0;
+    virtual bool isDirectory() const=0;
+    virtual SubtreeStats getStats() const=0;
+    
+    Directory* getParent() const{
+        return parent;
+    }
+    
+    // "/movies/marvels/avengers.mp3" and 2 for avengers.mp3; both O(depth)
+    string getPath() const;
+    int getDepth() const;
+    
     virtual ~FileSystemComponent() {}
 };
 
@@ -21,47 +51,1087 @@ public:
 class File:public FileSystemComponent{
 private:
     string fileName;
+    uint64_t size;
+    int64_t mtime;
 public:
-    File(string fileName):fileName(fileName){}
+    File(string fileName, uint64_t size = 0, int64_t mtime = 0):fileName(fileName),size(size),mtime(mtime){}
     void printContent() override{
-        cout<<"File name "<<fileName<<endl;
+        cout<<"File name "<<fileName<<'\n';
+    }
+    
+    const string& getName() const override{
+        return fileName;
+    }
+    
+    bool isDirectory() const override{
+        return false;
+    }
+    
+    SubtreeStats getStats() const override{
+        return {size, 1, mtime};
+    }
+    
+    uint64_t getSize() const{
+        return size;
     }
     
+    int64_t getMtime() const{
+        return mtime;
+    }
+    
+    // both update every ancestor's totals, O(depth)
+    void resize(uint64_t newSize);
+    void setMtime(int64_t newMtime);
 };
 
 class Directory:public FileSystemComponent{
 private:    
     vector<FileSystemComponent*>childrens;
+    // child name -> position in childrens; keys view the child's own name
+    unordered_map<string_view, size_t>childIndex;
     string directoryName;
+    SubtreeStats totals;
+    
+    static thread_local int bulkDepth;
+    friend class BulkUpdate;
+    friend class FileSystemImporter;
+    
+    int64_t newestChildMtime() const{
+        int64_t newest = 0;
+        for(auto child:childrens){
+            newest = max(newest, child->getStats().newestMtime);
+        }
+        return newest;
+    }
+    
+    // true for this directory and everything above it: adding one of them
+    // here would close a parent cycle. O(depth)
+    bool isSelfOrAncestor(const FileSystemComponent *component) const{
+        for(const Directory* dir=this;dir!=nullptr;dir=dir->parent){
+            if(dir == component) return true;
+        }
+        return false;
+    }
+    
+    // rebuilds totals for the whole subtree bottom-up, O(subtree)
+    void recomputeStats(){
+        totals = SubtreeStats();
+        for(auto child:childrens){
+            if(child->isDirectory()) static_cast<Directory*>(child)->recomputeStats();
+            SubtreeStats stats = child->getStats();
+            totals.bytes += stats.bytes;
+            totals.fileCount += stats.fileCount;
+            totals.newestMtime = max(totals.newestMtime, stats.newestMtime);
+        }
+    }
+    
 public:
     Directory(string directoryName):directoryName(directoryName){}
     
-    void add(FileSystemComponent *fileSystemComponent){
+    // walks from this directory to the root applying a change below it.
+    // a newer mtime is a max(); losing the newest mtime (removedMtime) needs
+    // a rescan of that ancestor's children, which is the only non-O(1) step
+    void propagate(int64_t deltaBytes, int64_t deltaFiles, int64_t addedMtime, int64_t removedMtime){
+        if(bulkDepth > 0) return;
+        for(Directory* dir=this;dir!=nullptr;dir=dir->parent){
+            dir->totals.bytes += deltaBytes;
+            dir->totals.fileCount += deltaFiles;
+            if(addedMtime > dir->totals.newestMtime){
+                dir->totals.newestMtime = addedMtime;
+            }
+            else if(removedMtime != 0 && removedMtime >= dir->totals.newestMtime){
+                dir->totals.newestMtime = dir->newestChildMtime();
+            }
+        }
+    }
+    
+    // names are unique within a directory, duplicates are rejected, and so
+    // are this directory and its ancestors. a node has one parent, adding
+    // it elsewhere moves it here
+    bool add(FileSystemComponent *fileSystemComponent){
+        if(isSelfOrAncestor(fileSystemComponent)) return false;
+        if(!childIndex.emplace(fileSystemComponent->getName(), childrens.size()).second){
+            return false;
+        }
+        if(fileSystemComponent->parent != nullptr){
+            fileSystemComponent->parent->reomve(fileSystemComponent);
+        }
         childrens.push_back(fileSystemComponent);
+        fileSystemComponent->parent = this;
+        SubtreeStats stats = fileSystemComponent->getStats();
+        propagate(stats.bytes, stats.fileCount, stats.newestMtime, 0);
+        return true;
     }
-    void reomve(FileSystemComponent *fileSystemComponent){
-        childrens.erase(remove(childrens.begin(), childrens.end(), fileSystemComponent), childrens.end());
+    
+    // batched add: one pass up the ancestors for the whole batch.
+    // duplicates and would-be cycles are skipped and left to the caller
+    size_t addAll(const vector<FileSystemComponent*>& batch){
+        SubtreeStats added;
+        size_t count = 0;
+        childrens.reserve(childrens.size() + batch.size());
+        childIndex.reserve(childIndex.size() + batch.size());
+        for(auto child:batch){
+            if(isSelfOrAncestor(child)) continue;
+            if(!childIndex.emplace(child->getName(), childrens.size()).second) continue;
+            if(child->parent != nullptr) child->parent->reomve(child);
+            childrens.push_back(child);
+            child->parent = this;
+            SubtreeStats stats = child->getStats();
+            added.bytes += stats.bytes;
+            added.fileCount += stats.fileCount;
+            added.newestMtime = max(added.newestMtime, stats.newestMtime);
+            count++;
+        }
+        propagate(added.bytes, added.fileCount, added.newestMtime, 0);
+        return count;
     }
     
-    void printContent() override{
-        cout<<"Directory Name:"<<directoryName<<endl;
-        for(auto it:childrens){
-            it->printContent();
+    // O(1): the last child is moved into the freed slot, so order is not kept
+    bool reomve(FileSystemComponent *fileSystemComponent){
+        auto it = childIndex.find(fileSystemComponent->getName());
+        if(it == childIndex.end() || childrens[it->second] != fileSystemComponent){
+            return false;
+        }
+        size_t pos = it->second;
+        childIndex.erase(it);
+        if(pos != childrens.size() - 1){
+            childrens[pos] = childrens.back();
+            childIndex[childrens[pos]->getName()] = pos;
+        }
+        childrens.pop_back();
+        fileSystemComponent->parent = nullptr;
+        SubtreeStats stats = fileSystemComponent->getStats();
+        propagate(-(int64_t)stats.bytes, -(int64_t)stats.fileCount, 0, stats.newestMtime);
+        return true;
+    }
+    
+    FileSystemComponent* getChild(string_view name) const{
+        auto it = childIndex.find(name);
+        return it == childIndex.end() ? nullptr : childrens[it->second];
+    }
+    
+    // "/movies/marvels/avengers.mp3" starts at this directory's own name,
+    // "marvels/avengers.mp3" is relative to it; cost is O(depth)
+    FileSystemComponent* resolve(string_view path){
+        FileSystemComponent* current = this;
+        bool absolute = !path.empty() && path[0] == '/';
+        size_t start = 0;
+        while(start <= path.size()){
+            size_t end = path.find('/', start);
+            if(end == string_view::npos) end = path.size();
+            string_view part = path.substr(start, end - start);
+            start = end + 1;
+            if(part.empty() || part == ".") continue;
+            if(absolute){
+                if(part != directoryName) return nullptr;
+                absolute = false;
+                continue;
+            }
+            if(!current->isDirectory()) return nullptr;
+            current = static_cast<Directory*>(current)->getChild(part);
+            if(current == nullptr) return nullptr;
+        }
+        return absolute ? nullptr : current;
+    }
+    
+    // streams the subtree through TreeExporter, see below
+    void printContent() override;
+
+    const string& getName() const override{
+        return directoryName;
+    }
+    
+    bool isDirectory() const override{
+        return true;
+    }
+    
+    // cached, O(1)
+    SubtreeStats getStats() const override{
+        return totals;
+    }
+    
+    // insertion order, except that reomve() moves the last child into the gap
+    const vector<FileSystemComponent*>& getChildren() const{
+        return childrens;
+    }
+};
+
+thread_local int Directory::bulkDepth = 0;
+
+// pauses incremental maintenance on this thread for a bulk import and
+// recomputes root's subtree once at the end. everything touched during the
+// import must live under root
+class BulkUpdate{
+    Directory* root;
+    SubtreeStats before;
+public:
+    BulkUpdate(Directory* root):root(root),before(root->getStats()){
+        Directory::bulkDepth++;
+    }
+    
+    ~BulkUpdate(){
+        if(--Directory::bulkDepth > 0) return;
+        root->recomputeStats();
+        // root's net change still has to reach its ancestors
+        SubtreeStats after = root->getStats();
+        if(root->getParent() != nullptr){
+            root->getParent()->propagate((int64_t)after.bytes - (int64_t)before.bytes,
+                                         (int64_t)after.fileCount - (int64_t)before.fileCount,
+                                         after.newestMtime,
+                                         after.newestMtime < before.newestMtime ? before.newestMtime : 0);
         }
     }
+};
 
+void File::resize(uint64_t newSize){
+    int64_t delta = (int64_t)newSize - (int64_t)size;
+    size = newSize;
+    if(parent != nullptr) parent->propagate(delta, 0, 0, 0);
+}
+
+void File::setMtime(int64_t newMtime){
+    int64_t old = mtime;
+    mtime = newMtime;
+    if(parent != nullptr) parent->propagate(0, 0, newMtime, newMtime < old ? old : 0);
+}
+
+
+/******************************************************************************
+
+Tree export
+
+TreeExporter streams a subtree through one reusable buffer and only hands
+full buffers to the output (a raw fd or an ostream), so nothing is flushed
+per line. the walk is iterative over an explicit stack, and the full path
+is kept in a single string that is appended to / truncated as the walk
+moves, so exporting needs no per-node allocation.
+
+*******************************************************************************/
+
+class TreeExporter{
+public:
+    enum Format{
+        TEXT,           // printContent layout
+        INDENTED_TEXT,  // printContent layout, two spaces per level
+        JSON_LINES,     // {"path":...,"type":...,"size":...,"mtime":...} per node
+    };
+    
+private:
+    ostream* stream;
+    int fd;
+    vector<char> buffer;
+    size_t used;
+    
+    struct Frame{
+        FileSystemComponent* node;
+        uint32_t depth;
+        uint32_t parentPathLength;
+    };
+    vector<Frame> stack;
+    string path;
+    
+    void reserve(size_t bytes){
+        if(used + bytes > buffer.size()) flush();
+        if(bytes > buffer.size()) buffer.resize(bytes);
+    }
+    
+    void append(const char* data, size_t length){
+        reserve(length);
+        memcpy(buffer.data() + used, data, length);
+        used += length;
+    }
+    
+    void append(const string& text){
+        append(text.data(), text.size());
+    }
+    
+    void append(char c){
+        reserve(1);
+        buffer[used++] = c;
+    }
+    
+    void appendNumber(int64_t value){
+        char digits[24];
+        char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+        append(digits, end - digits);
+    }
+    
+    void appendJsonString(const string& text){
+        append('"');
+        bool plain = none_of(text.begin(), text.end(), [](char c){
+            return c == '"' || c == '\\' || (unsigned char)c < 0x20;
+        });
+        if(plain){
+            append(text);
+            append('"');
+            return;
+        }
+        for(char c:text){
+            if(c == '"' || c == '\\'){
+                append('\\');
+                append(c);
+            }
+            else if((unsigned char)c < 0x20){
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                append(escaped, 6);
+            }
+            else append(c);
+        }
+        append('"');
+    }
+    
+    void writeNode(FileSystemComponent* node, uint32_t depth, Format format){
+        bool directory = node->isDirectory();
+        if(format == JSON_LINES){
+            SubtreeStats stats = node->getStats();
+            append("{\"path\":", 8);
+            appendJsonString(path);
+            append(directory ? ",\"type\":\"directory\",\"size\":" : ",\"type\":\"file\",\"size\":", directory ? 27 : 22);
+            appendNumber((int64_t)stats.bytes);
+            append(",\"mtime\":", 9);
+            appendNumber(stats.newestMtime);
+            append("}\n", 2);
+            return;
+        }
+        if(format == INDENTED_TEXT){
+            reserve(depth * 2);
+            memset(buffer.data() + used, ' ', depth * 2);
+            used += depth * 2;
+        }
+        if(directory) append("Directory Name:", 15);
+        else append("File name ", 10);
+        append(node->getName());
+        append('\n');
+    }
+    
+public:
+    explicit TreeExporter(int fd, size_t bufferSize = 1 << 20)
+        : stream(nullptr), fd(fd), buffer(bufferSize), used(0) {}
+    
+    explicit TreeExporter(ostream& out, size_t bufferSize = 1 << 20)
+        : stream(&out), fd(-1), buffer(bufferSize), used(0) {}
     
+    // pre-order, children in getChildren() order, same as printContent.
+    // that is insertion order only until a reomve(): it moves the last
+    // child into the freed slot, so consumers must not rely on sibling order
+    void write(FileSystemComponent* root, Format format){
+        path = root->getPath();
+        stack.clear();
+        stack.push_back({root, 0, (uint32_t)(path.size() - root->getName().size() - 1)});
+        while(!stack.empty()){
+            Frame frame = stack.back();
+            stack.pop_back();
+            path.resize(frame.parentPathLength);
+            path += '/';
+            path += frame.node->getName();
+            writeNode(frame.node, frame.depth, format);
+            if(!frame.node->isDirectory()) continue;
+            const auto& children = static_cast<Directory*>(frame.node)->getChildren();
+            for(size_t i=children.size();i-->0;){
+                stack.push_back({children[i], frame.depth + 1, (uint32_t)path.size()});
+            }
+        }
+        flush();
+    }
     
+    void flush(){
+        if(used == 0) return;
+        if(stream != nullptr){
+            stream->write(buffer.data(), used);
+            stream->flush();
+        }
+        else{
+            for(size_t done=0;done<used;){
+                ssize_t written = ::write(fd, buffer.data() + done, used - done);
+                if(written < 0){
+                    if(errno == EINTR) continue;
+                    break;
+                }
+                done += written;
+            }
+        }
+        used = 0;
+    }
+    
+    ~TreeExporter(){
+        flush();
+    }
 };
 
-int main()
+void Directory::printContent(){
+    TreeExporter(cout, 1 << 16).write(this, TreeExporter::TEXT);
+}
+
+string FileSystemComponent::getPath() const{
+    vector<const FileSystemComponent*> chain;
+    for(const FileSystemComponent* node=this;node!=nullptr;node=node->parent){
+        chain.push_back(node);
+    }
+    string path;
+    for(size_t i=chain.size();i-->0;){
+        path += '/';
+        path += chain[i]->getName();
+    }
+    return path;
+}
+
+int FileSystemComponent::getDepth() const{
+    int depth = 0;
+    for(const FileSystemComponent* node=parent;node!=nullptr;node=node->parent){
+        depth++;
+    }
+    return depth;
+}
+
+
+/******************************************************************************
+
+Arena storage mode
+
+the whole tree lives in one FileSystemArena as parallel arrays indexed by
+node id (kind, name offset/length into a shared string pool, parent and
+first/last child and prev/next sibling links); nodes are plain uint32 ids.
+
+the arena is its own type, not storage behind File / Directory: the name
+index, cached subtree stats, ParallelTreeWalker, FileSystemImporter and
+TreeExporter below all work on FileSystemComponent pointers, and moving
+the canonical tree onto ids would rewrite each of them. it is the compact
+mode for trees that only need structure and names; runLayoutBenchmark
+compares the two layouts.
+
+*******************************************************************************/
+
+class FileSystemArena{
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    enum Kind : uint8_t{
+        FILE_NODE,
+        DIRECTORY_NODE,
+    };
+    
+private:
+    vector<Kind> kinds;
+    vector<uint32_t> nameOffsets;
+    vector<uint32_t> nameLengths;
+    vector<uint32_t> parents;
+    vector<uint32_t> firstChildren;
+    vector<uint32_t> lastChildren;
+    vector<uint32_t> prevSiblings;
+    vector<uint32_t> nextSiblings;
+    string namePool;
+    
+public:
+    void reserve(size_t nodes, size_t nameBytes){
+        kinds.reserve(nodes);
+        nameOffsets.reserve(nodes);
+        nameLengths.reserve(nodes);
+        parents.reserve(nodes);
+        firstChildren.reserve(nodes);
+        lastChildren.reserve(nodes);
+        prevSiblings.reserve(nodes);
+        nextSiblings.reserve(nodes);
+        namePool.reserve(nameBytes);
+    }
+    
+    uint32_t create(Kind kind, const string& name){
+        uint32_t id = (uint32_t)kinds.size();
+        kinds.push_back(kind);
+        nameOffsets.push_back((uint32_t)namePool.size());
+        nameLengths.push_back((uint32_t)name.size());
+        namePool += name;
+        parents.push_back(NONE);
+        firstChildren.push_back(NONE);
+        lastChildren.push_back(NONE);
+        prevSiblings.push_back(NONE);
+        nextSiblings.push_back(NONE);
+        return id;
+    }
+    
+    // same rules as Directory::add: false for a non-directory target, for
+    // the directory itself or one of its ancestors (a parent cycle), and
+    // for a name already taken among its children. a node has exactly one
+    // parent, so adding an attached node moves it. O(depth + children)
+    bool addChild(uint32_t directory, uint32_t child){
+        if(kinds[directory] != DIRECTORY_NODE) return false;
+        for(uint32_t node=directory;node!=NONE;node=parents[node]){
+            if(node == child) return false;
+        }
+        string_view name = getName(child);
+        for(uint32_t sibling=firstChildren[directory];sibling!=NONE;sibling=nextSiblings[sibling]){
+            if(getName(sibling) == name) return false;
+        }
+        if(parents[child] != NONE) removeChild(parents[child], child);
+        parents[child] = directory;
+        prevSiblings[child] = lastChildren[directory];
+        if(lastChildren[directory] == NONE) firstChildren[directory] = child;
+        else nextSiblings[lastChildren[directory]] = child;
+        lastChildren[directory] = child;
+        return true;
+    }
+    
+    void removeChild(uint32_t directory, uint32_t child){
+        if(parents[child] != directory) return;
+        uint32_t prev = prevSiblings[child], next = nextSiblings[child];
+        if(prev == NONE) firstChildren[directory] = next;
+        else nextSiblings[prev] = next;
+        if(next == NONE) lastChildren[directory] = prev;
+        else prevSiblings[next] = prev;
+        parents[child] = prevSiblings[child] = nextSiblings[child] = NONE;
+    }
+    
+    Kind getKind(uint32_t id) const{ return kinds[id]; }
+    uint32_t getParent(uint32_t id) const{ return parents[id]; }
+    uint32_t getFirstChild(uint32_t id) const{ return firstChildren[id]; }
+    uint32_t getNextSibling(uint32_t id) const{ return nextSiblings[id]; }
+    
+    string_view getName(uint32_t id) const{
+        return string_view(namePool.data() + nameOffsets[id], nameLengths[id]);
+    }
+    
+    size_t size() const{
+        return kinds.size();
+    }
+    
+    // same layout as Directory::printContent. pre-order without a stack:
+    // down through first children, across through next siblings, back up
+    // through parents; lines collect in one buffer that goes to the stream
+    // in 64 KB chunks
+    void printContent(uint32_t id, ostream& out = cout) const{
+        const size_t chunk = 1 << 16;
+        string buffer;
+        buffer.reserve(chunk);
+        uint32_t node = id;
+        while(true){
+            buffer += kinds[node] == FILE_NODE ? "File name " : "Directory Name:";
+            buffer += getName(node);
+            buffer += '\n';
+            if(buffer.size() >= chunk){
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+            if(firstChildren[node] != NONE){
+                node = firstChildren[node];
+                continue;
+            }
+            while(node != id && nextSiblings[node] == NONE) node = parents[node];
+            if(node == id) break;
+            node = nextSiblings[node];
+        }
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+    }
+};
+
+
+/******************************************************************************
+
+Parallel traversal
+
+ParallelTreeWalker splits the tree by child directories. a worker walks
+depth first with an explicit stack, and whenever its own deque is empty it
+publishes the next child directory there instead, so there is always
+stealable work while it has unvisited directories. a worker pops its own
+newest task (LIFO, cache friendly) and steals the oldest task from another
+worker when it runs dry. each worker folds into its own cache-line aligned
+Result; results are merged once at the end.
+
+*******************************************************************************/
+
+class ParallelTreeWalker{
+    struct Task{
+        Directory* directory;
+        string path;
+    };
+    
+    struct alignas(64) WorkerQueue{
+        mutex queueMutex;
+        deque<Task> tasks;
+        atomic<size_t> size{0};     // tasks.size(), readable without the lock
+    };
+    
+    // one per worker on its own cache line, so workers folding into
+    // neighbouring results do not share lines
+    template<typename Result>
+    struct alignas(64) WorkerResult{
+        Result value;
+    };
+    
+    int threadCount;
+    
+public:
+    ParallelTreeWalker(int threadCount = (int)max(1u, thread::hardware_concurrency()))
+        : threadCount(max(threadCount, 1)) {}
+    
+    // visit(node, parentPath, local) is called exactly once for every node
+    // below root (root itself excluded), in no particular order
+    template<typename Result, typename Visit, typename Merge>
+    Result run(Directory* root, const string& rootPath, Visit visit, Merge merge){
+        vector<unique_ptr<WorkerQueue>> queues;
+        for(int i=0;i<threadCount;i++) queues.push_back(make_unique<WorkerQueue>());
+        vector<WorkerResult<Result>> results(threadCount);
+        atomic<size_t> pending(1);
+        queues[0]->tasks.push_back({root, rootPath});
+        queues[0]->size = 1;
+        
+        auto worker = [&](int id){
+            Result& local = results[id].value;
+            WorkerQueue& own = *queues[id];
+            vector<pair<Directory*, string>> stack;
+            auto process = [&](Task& task){
+                stack.emplace_back(task.directory, move(task.path));
+                while(!stack.empty()){
+                    Directory* directory = stack.back().first;
+                    string path = move(stack.back().second);
+                    stack.pop_back();
+                    for(FileSystemComponent* child:directory->getChildren()){
+                        visit(child, path, local);
+                        if(!child->isDirectory()) continue;
+                        Directory* sub = static_cast<Directory*>(child);
+                        string subPath = path + "/" + sub->getName();
+                        if(threadCount > 1 && own.size.load(memory_order_relaxed) == 0){
+                            pending.fetch_add(1, memory_order_relaxed);
+                            lock_guard<mutex> lock(own.queueMutex);
+                            own.tasks.push_back({sub, move(subPath)});
+                            own.size.store(own.tasks.size(), memory_order_relaxed);
+                        }
+                        else stack.emplace_back(sub, move(subPath));
+                    }
+                }
+            };
+            auto popLocal = [&](Task& task){
+                lock_guard<mutex> lock(own.queueMutex);
+                if(own.tasks.empty()) return false;
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                own.size.store(own.tasks.size(), memory_order_relaxed);
+                return true;
+            };
+            auto steal = [&](Task& task){
+                for(int k=1;k<threadCount;k++){
+                    WorkerQueue& victim = *queues[(id + k) % threadCount];
+                    lock_guard<mutex> lock(victim.queueMutex);
+                    if(victim.tasks.empty()) continue;
+                    task = move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    victim.size.store(victim.tasks.size(), memory_order_relaxed);
+                    return true;
+                }
+                return false;
+            };
+            
+            Task task;
+            while(true){
+                if(popLocal(task) || steal(task)){
+                    process(task);
+                    pending.fetch_sub(1, memory_order_acq_rel);
+                }
+                else if(pending.load(memory_order_acquire) == 0) return;
+                else this_thread::yield();
+            }
+        };
+        
+        vector<thread> threads;
+        for(int i=1;i<threadCount;i++) threads.emplace_back(worker, i);
+        worker(0);
+        for(auto& t:threads) t.join();
+        
+        Result total = move(results[0].value);
+        for(int i=1;i<threadCount;i++) merge(total, results[i].value);
+        return total;
+    }
+    
+    vector<FileSystemComponent*> find(Directory* root, const function<bool(FileSystemComponent*)>& predicate){
+        using Matches = vector<FileSystemComponent*>;
+        return run<Matches>(root, root->getName(),
+            [&](FileSystemComponent* node, const string&, Matches& local){
+                if(predicate(node)) local.push_back(node);
+            },
+            [](Matches& total, Matches& part){
+                total.insert(total.end(), part.begin(), part.end());
+            });
+    }
+    
+    // full recount, independent of the cached totals
+    SubtreeStats aggregate(Directory* root){
+        return run<SubtreeStats>(root, root->getName(),
+            [](FileSystemComponent* node, const string&, SubtreeStats& local){
+                if(node->isDirectory()) return;
+                File* file = static_cast<File*>(node);
+                local.bytes += file->getSize();
+                local.fileCount++;
+                local.newestMtime = max(local.newestMtime, file->getMtime());
+            },
+            [](SubtreeStats& total, SubtreeStats& part){
+                total.bytes += part.bytes;
+                total.fileCount += part.fileCount;
+                total.newestMtime = max(total.newestMtime, part.newestMtime);
+            });
+    }
+    
+    // one "full/path<TAB>size" line per file, unordered
+    vector<string> exportPaths(Directory* root){
+        using Lines = vector<string>;
+        return run<Lines>(root, root->getPath(),
+            [](FileSystemComponent* node, const string& parentPath, Lines& local){
+                if(node->isDirectory()) return;
+                local.push_back(parentPath + "/" + node->getName() + "\t" +
+                                to_string(static_cast<File*>(node)->getSize()));
+            },
+            [](Lines& total, Lines& part){
+                move(part.begin(), part.end(), back_inserter(total));
+            });
+    }
+};
+
+
+/******************************************************************************
+
+Real filesystem importer
+
+workers pull directories from a shared queue, read entries with raw
+getdents64 into a 64KB buffer, statx each non-directory relative to the
+open directory fd and insert the whole batch with Directory::addAll.
+subtree totals are not maintained per insert (each worker runs in bulk
+mode); the tree is recomputed once after all workers finish.
+
+*******************************************************************************/
+
+struct LinuxDirent64{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+class FileSystemImporter{
+    struct Task{
+        Directory* directory;
+        string path;
+    };
+    
+    int threadCount;
+    mutex queueMutex;
+    condition_variable queueSignal;
+    deque<Task> queue;
+    size_t pending;
+    atomic<uint64_t> errors;
+    
+    void scan(const Task& task, vector<char>& buffer, vector<Task>& subdirectories){
+        int fd = openat(AT_FDCWD, task.path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if(fd < 0){
+            errors.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        vector<FileSystemComponent*> batch;
+        while(true){
+            long bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if(bytes <= 0){
+                if(bytes < 0) errors.fetch_add(1, memory_order_relaxed);
+                break;
+            }
+            for(long offset=0;offset<bytes;){
+                auto entry = reinterpret_cast<LinuxDirent64*>(buffer.data() + offset);
+                offset += entry->d_reclen;
+                const char* name = entry->d_name;
+                if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+                
+                // d_type is DT_UNKNOWN on some filesystems, statx settles it
+                bool isDirectory = entry->d_type == DT_DIR;
+                struct statx st;
+                if(!isDirectory){
+                    if(statx(fd, name, AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_SIZE | STATX_MTIME, &st) != 0){
+                        errors.fetch_add(1, memory_order_relaxed);
+                        continue;
+                    }
+                    isDirectory = S_ISDIR(st.stx_mode);
+                }
+                if(isDirectory){
+                    Directory* sub = new Directory(name);
+                    batch.push_back(sub);
+                    subdirectories.push_back({sub, task.path + "/" + name});
+                }
+                else{
+                    batch.push_back(new File(name, st.stx_size, st.stx_mtime.tv_sec));
+                }
+            }
+        }
+        close(fd);
+        task.directory->addAll(batch);
+    }
+    
+    void worker(){
+        Directory::bulkDepth++;
+        vector<char> buffer(1 << 16);
+        vector<Task> subdirectories;
+        unique_lock<mutex> lock(queueMutex);
+        while(true){
+            queueSignal.wait(lock, [this](){ return !queue.empty() || pending == 0; });
+            if(queue.empty()) break;
+            Task task = move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            
+            scan(task, buffer, subdirectories);
+            
+            lock.lock();
+            for(auto& sub:subdirectories) queue.push_back(move(sub));
+            pending += subdirectories.size();
+            pending--;
+            subdirectories.clear();
+            queueSignal.notify_all();
+        }
+        Directory::bulkDepth--;
+    }
+    
+public:
+    FileSystemImporter(int threadCount = 8) : threadCount(max(threadCount, 1)), pending(0), errors(0) {}
+    
+    // returns nullptr if path is not a readable directory
+    Directory* import(const string& path){
+        struct stat st;
+        if(stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return nullptr;
+        string name = path.substr(path.find_last_of('/', path.size() - 2) + 1);
+        if(!name.empty() && name.back() == '/') name.pop_back();
+        Directory* root = new Directory(name.empty() ? "/" : name);
+        
+        queue.push_back({root, path});
+        pending = 1;
+        errors = 0;
+        vector<thread> threads;
+        for(int i=0;i<threadCount;i++) threads.emplace_back(&FileSystemImporter::worker, this);
+        for(auto& t:threads) t.join();
+        
+        root->recomputeStats();
+        return root;
+    }
+    
+    // entries that could not be opened or stat'ed during the last import
+    uint64_t getErrorCount() const{
+        return errors.load(memory_order_relaxed);
+    }
+};
+
+
+/******************************************************************************
+Benchmarks: ./a.out bench
+*******************************************************************************/
+
+// visits every node, returns number of files + total name bytes
+pair<size_t, size_t> walkPointerTree(const FileSystemComponent* root){
+    size_t files = 0, nameBytes = 0;
+    vector<const FileSystemComponent*> stack = {root};
+    while(!stack.empty()){
+        const FileSystemComponent* node = stack.back();
+        stack.pop_back();
+        nameBytes += node->getName().size();
+        if(!node->isDirectory()){
+            files++;
+            continue;
+        }
+        for(auto child:static_cast<const Directory*>(node)->getChildren()){
+            stack.push_back(child);
+        }
+    }
+    return {files, nameBytes};
+}
+
+pair<size_t, size_t> walkArenaTree(const FileSystemArena& arena, uint32_t root){
+    size_t files = 0, nameBytes = 0;
+    vector<uint32_t> stack = {root};
+    while(!stack.empty()){
+        uint32_t node = stack.back();
+        stack.pop_back();
+        nameBytes += arena.getName(node).size();
+        if(arena.getKind(node) == FileSystemArena::FILE_NODE){
+            files++;
+            continue;
+        }
+        for(uint32_t child=arena.getFirstChild(node);child!=FileSystemArena::NONE;child=arena.getNextSibling(child)){
+            stack.push_back(child);
+        }
+    }
+    return {files, nameBytes};
+}
+
+// balanced tree: node i hangs off node (i-1)/fanout, the first
+// directoryCount nodes are the directories
+size_t benchDirectoryCount(size_t nodes, size_t fanout){
+    return (nodes - 1 + fanout - 1) / fanout;
+}
+
+string benchNodeName(size_t i, size_t directoryCount){
+    return i < directoryCount ? "dir_" + to_string(i) : "file_" + to_string(i) + ".dat";
+}
+
+Directory* buildBenchTree(size_t nodes, size_t fanout){
+    const size_t directoryCount = benchDirectoryCount(nodes, fanout);
+    Directory* root = new Directory("root");
+    vector<Directory*> directories = {root};
+    BulkUpdate bulk(root);
+    for(size_t i=1;i<nodes;i++){
+        Directory* parent = directories[(i - 1) / fanout];
+        if(i < directoryCount){
+            directories.push_back(new Directory(benchNodeName(i, directoryCount)));
+            parent->add(directories.back());
+        }
+        else parent->add(new File(benchNodeName(i, directoryCount), i % 4096, (int64_t)i));
+    }
+    return root;
+}
+
+void runLayoutBenchmark(){
+    const size_t nodes = 4000000;
+    const size_t fanout = 32;
+    const size_t directoryCount = benchDirectoryCount(nodes, fanout);
+    
+    auto bestOf = [](auto&& walk){
+        double best = 1e18;
+        pair<size_t, size_t> result;
+        for(int run=0;run<5;run++){
+            auto start = chrono::steady_clock::now();
+            result = walk();
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        return make_pair(best, result);
+    };
+    
+    size_t before = mallinfo2().uordblks;
+    Directory* root = buildBenchTree(nodes, fanout);
+    size_t pointerBytes = mallinfo2().uordblks - before;
+    auto pointer = bestOf([&](){ return walkPointerTree(root); });
+    
+    before = mallinfo2().uordblks;
+    FileSystemArena* arena = new FileSystemArena();
+    uint32_t arenaRoot = arena->create(FileSystemArena::DIRECTORY_NODE, "root");
+    for(size_t i=1;i<nodes;i++){
+        auto kind = i < directoryCount ? FileSystemArena::DIRECTORY_NODE : FileSystemArena::FILE_NODE;
+        uint32_t id = arena->create(kind, benchNodeName(i, directoryCount));
+        arena->addChild((uint32_t)((i - 1) / fanout), id);
+    }
+    size_t arenaBytes = mallinfo2().uordblks - before;
+    auto soa = bestOf([&](){ return walkArenaTree(*arena, arenaRoot); });
+    
+    if(pointer.second != soa.second) cout<<"layouts disagree!"<<endl;
+    cout<<nodes<<" nodes, "<<pointer.second.first<<" files"<<endl;
+    cout<<"pointer tree: "<<pointerBytes / (1 << 20)<<" MB, traversal "
+        <<nodes / pointer.first / 1e6<<" M nodes/s"<<endl;
+    cout<<"arena tree:   "<<arenaBytes / (1 << 20)<<" MB, traversal "
+        <<nodes / soa.first / 1e6<<" M nodes/s"<<endl;
+}
+
+void runTraversalBenchmark(){
+    const size_t nodes = 4000000;
+    Directory* root = buildBenchTree(nodes, 32);
+    auto endsWith7 = [](FileSystemComponent* node){
+        const string& name = node->getName();
+        return name.size() > 5 && name.compare(name.size() - 5, 5, "7.dat") == 0;
+    };
+    
+    int hardware = (int)max(1u, thread::hardware_concurrency());
+    double baseline = 0;
+    for(int threads=1;;threads=min(threads * 2, hardware)){
+        ParallelTreeWalker walker(threads);
+        auto start = chrono::steady_clock::now();
+        size_t matches = walker.find(root, endsWith7).size();
+        SubtreeStats stats = walker.aggregate(root);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if(threads == 1) baseline = seconds;
+        cout<<threads<<" threads: find+aggregate "<<2 * nodes / seconds / 1e6<<" M nodes/s, speedup "
+            <<baseline / seconds<<" ("<<matches<<" matches, "<<stats.fileCount<<" files)"<<endl;
+        if(threads == hardware) break;
+    }
+}
+
+// generates a synthetic tree under /tmp and imports it with growing thread counts
+void runImportBenchmark(){
+    namespace fs = std::filesystem;
+    const int topDirectories = 20, subDirectories = 20, filesPerDirectory = 100;
+    fs::path base = fs::temp_directory_path() / ("import_bench_" + to_string(getpid()));
+    for(int i=0;i<topDirectories;i++){
+        for(int j=0;j<subDirectories;j++){
+            fs::path dir = base / ("d" + to_string(i)) / ("s" + to_string(j));
+            fs::create_directories(dir);
+            for(int k=0;k<filesPerDirectory;k++){
+                ofstream(dir / ("f" + to_string(k) + ".dat")) << string(k, 'x');
+            }
+        }
+    }
+    size_t entries = topDirectories * subDirectories * (filesPerDirectory + 1) + topDirectories;
+    
+    for(int threads:{1, 2, 4, 8, 16}){
+        FileSystemImporter importer(threads);
+        auto start = chrono::steady_clock::now();
+        Directory* root = importer.import(base.string());
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout<<"import, "<<threads<<" threads: "<<entries / seconds / 1e6<<" M entries/s ("
+            <<root->getStats().fileCount<<" files, "<<importer.getErrorCount()<<" errors)"<<endl;
+    }
+    fs::remove_all(base);
+}
+
+void runExportBenchmark(){
+    const size_t nodes = 4000000;
+    Directory* root = buildBenchTree(nodes, 32);
+    int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    ofstream nullStream("/dev/null");
+    
+    auto report = [&](const char* name, auto&& run){
+        auto start = chrono::steady_clock::now();
+        run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout<<name<<": "<<nodes / seconds / 1e6<<" M nodes/s"<<endl;
+    };
+    // what printContent used to do: recursion plus endl on every line
+    function<void(FileSystemComponent*)> legacy = [&](FileSystemComponent* node){
+        if(!node->isDirectory()){
+            nullStream<<"File name "<<node->getName()<<endl;
+            return;
+        }
+        nullStream<<"Directory Name:"<<node->getName()<<endl;
+        for(auto child:static_cast<Directory*>(node)->getChildren()) legacy(child);
+    };
+    report("recursive printContent, endl", [&](){ legacy(root); });
+    
+    TreeExporter exporter(devNull);
+    report("TreeExporter text", [&](){ exporter.write(root, TreeExporter::INDENTED_TEXT); });
+    report("TreeExporter json lines", [&](){ exporter.write(root, TreeExporter::JSON_LINES); });
+    close(devNull);
+}
+
+
+// benchmarks/ include this file for its classes and supply their own main
+#ifndef LLD_NO_MAIN
+int main(int argc, char** argv)
 {
-    File *reciept = new File("reciept.pdf");
-    File *invoice = new File("invoice.pdf");
-    File *torrent = new File("torrent.txt");
-    File *avengers = new File("avengers.mp3");
-    File *ironman = new File("ironman,mp3");
-    File *batman = new File("batman.mp3");
+    if(argc == 2 && string(argv[1]) == "bench"){
+        runLayoutBenchmark();
+        runTraversalBenchmark();
+        runImportBenchmark();
+        runExportBenchmark();
+        return 0;
+    }
+    if(argc == 3 && string(argv[1]) == "import"){
+        FileSystemImporter importer;
+        Directory* root = importer.import(argv[2]);
+        if(root == nullptr){
+            cout<<argv[2]<<" is not a directory"<<endl;
+            return 1;
+        }
+        SubtreeStats stats = root->getStats();
+        cout<<root->getName()<<": "<<stats.bytes<<" bytes, "<<stats.fileCount<<" files, "
+            <<importer.getErrorCount()<<" errors"<<endl;
+        return 0;
+    }
+    
+    File *reciept = new File("reciept.pdf", 120, 1700000000);
+    File *invoice = new File("invoice.pdf", 80, 1700000100);
+    File *torrent = new File("torrent.txt", 4, 1700000200);
+    File *avengers = new File("avengers.mp3", 9000, 1700000300);
+    File *ironman = new File("ironman,mp3", 7000, 1700000400);
+    File *batman = new File("batman.mp3", 8000, 1700000500);
     
     Directory *movies = new Directory("movies");
     Directory *marvelMovieDirector = new Directory("marvels");
@@ -73,9 +1143,70 @@ int main()
     movies->add(batman);
     marvelMovieDirector->add(ironman);
     marvelMovieDirector->add(avengers);
-    movies->add(marvelMovieDirector);
+    if(!movies->add(marvelMovieDirector)){
+        cout<<"marvels already exists in movies"<<endl;
+    }
     
     movies->printContent();
     
+    FileSystemComponent* found = movies->resolve("/movies/marvels/avengers.mp3");
+    cout<<"resolved: "<<(found ? found->getName() : "not found")<<endl;
+    movies->reomve(invoice);
+    cout<<"invoice.pdf after remove: "<<(movies->getChild("invoice.pdf") ? "present" : "gone")<<endl;
+    
+    // du: cached totals, kept up to date on add / remove / resize
+    auto du = [](FileSystemComponent* node){
+        SubtreeStats stats = node->getStats();
+        cout<<node->getName()<<": "<<stats.bytes<<" bytes, "<<stats.fileCount
+            <<" files, newest mtime "<<stats.newestMtime<<endl;
+    };
+    du(movies);
+    avengers->resize(12000);
+    du(marvelMovieDirector);
+    du(movies);
+    movies->reomve(batman);
+    du(movies);
+    {
+        BulkUpdate bulk(marvelMovieDirector);
+        for(int i=0;i<1000;i++){
+            marvelMovieDirector->add(new File("clip" + to_string(i) + ".mp4", 100, 1700001000 + i));
+        }
+    }
+    du(movies);
+    
+    ParallelTreeWalker walker(4);
+    auto mp3s = walker.find(movies, [](FileSystemComponent* node){
+        return node->getName().find("mp3") != string::npos;
+    });
+    cout<<"mp3 files found in parallel: "<<mp3s.size()<<endl;
+    SubtreeStats recount = walker.aggregate(movies);
+    cout<<"parallel recount: "<<recount.bytes<<" bytes, "<<recount.fileCount<<" files"<<endl;
+    for(auto& line:walker.exportPaths(marvelMovieDirector)){
+        if(line.find("clip") == string::npos) cout<<line<<endl;
+    }
+    
+    cout<<avengers->getPath()<<" at depth "<<avengers->getDepth()<<endl;
+    for(int i=0;i<1000;i++){
+        marvelMovieDirector->reomve(marvelMovieDirector->getChild("clip" + to_string(i) + ".mp4"));
+    }
+    TreeExporter stdoutExporter(STDOUT_FILENO);
+    cout.flush();
+    stdoutExporter.write(movies, TreeExporter::INDENTED_TEXT);
+    stdoutExporter.write(movies, TreeExporter::JSON_LINES);
+    
+    // same tree in arena storage
+    FileSystemArena arena;
+    uint32_t arenaMovies = arena.create(FileSystemArena::DIRECTORY_NODE, "movies");
+    uint32_t arenaMarvels = arena.create(FileSystemArena::DIRECTORY_NODE, "marvels");
+    arena.addChild(arenaMovies, arena.create(FileSystemArena::FILE_NODE, "reciept.pdf"));
+    arena.addChild(arenaMovies, arena.create(FileSystemArena::FILE_NODE, "invoice.pdf"));
+    arena.addChild(arenaMovies, arena.create(FileSystemArena::FILE_NODE, "torrent.txt"));
+    arena.addChild(arenaMovies, arenaMarvels);
+    arena.addChild(arenaMovies, arena.create(FileSystemArena::FILE_NODE, "batman.mp3"));
+    arena.addChild(arenaMarvels, arena.create(FileSystemArena::FILE_NODE, "ironman,mp3"));
+    arena.addChild(arenaMarvels, arena.create(FileSystemArena::FILE_NODE, "avengers.mp3"));
+    arena.printContent(arenaMovies);
+    
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,504 @@
+/******************************************************************************
+
+header-only runtime metrics shared by the design programs
+
+    Counter    monotonically increasing, sharded per thread
+    Gauge      signed value that moves both ways, sharded per thread
+    Histogram  log-linear (HDR-style) latency buckets, recorded in TSC ticks
+    Registry   owns every metric by name + labels, renders Prometheus text
+    PrometheusExporter  writes the text to a file on an interval, or serves
+               it over HTTP on a local port
+
+hot-path cost is a plain load + store on a cache line only the calling
+thread writes (plus a rdtsc pair for timers). look the
+metric up once and keep the reference, e.g. in a function-local static:
+
+    static metrics::Counter& conflicts =
+        metrics::Registry::global().counter("seat_lock_conflicts_total", "...");
+    conflicts.inc();
+
+*******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace metrics {
+
+constexpr int SHARDS = 32;
+
+// each live thread holds a shard of its own while there are free ones, so
+// the hot path is a plain load + store with no lock prefix; the slot goes
+// back to the pool when the thread exits (the next owner carries on from
+// the same values). threads beyond SHARDS get -1 and share an atomic cell
+class ShardSlot {
+    static std::atomic<uint64_t>& freeMask() {
+        static std::atomic<uint64_t> mask{SHARDS == 64 ? ~0ull : (1ull << SHARDS) - 1};
+        return mask;
+    }
+
+public:
+    int index = -1;
+
+    ShardSlot() {
+        uint64_t mask = freeMask().load(std::memory_order_relaxed);
+        while (mask) {
+            int slot = __builtin_ctzll(mask);
+            if (freeMask().compare_exchange_weak(mask, mask & ~(1ull << slot), std::memory_order_acquire)) {
+                index = slot;
+                return;
+            }
+        }
+    }
+
+    ~ShardSlot() {
+        if (index >= 0) freeMask().fetch_or(1ull << index, std::memory_order_release);
+    }
+};
+static_assert(SHARDS <= 64, "shard slots are tracked in one 64-bit mask");
+
+inline int shardIndex() {
+    thread_local ShardSlot slot;
+    return slot.index;
+}
+
+// adds to a cell only the calling thread writes
+inline void ownedAdd(std::atomic<int64_t>& cell, int64_t n) {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void ownedAdd(std::atomic<uint64_t>& cell, uint64_t n) {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// ---- clock ----
+
+// raw timestamp: the TSC where there is one, steady_clock ns elsewhere
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// measured once against steady_clock, on first use (takes ~20ms)
+inline double nanosPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double calibrated = []() {
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64_t tickStart = ticks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t tickEnd = ticks();
+        double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+        return nanos / double(tickEnd - tickStart);
+    }();
+    return calibrated;
+#else
+    return 1.0;
+#endif
+}
+
+// ---- counters and gauges ----
+
+struct alignas(64) PaddedCell {
+    std::atomic<int64_t> value{0};
+};
+
+// shard SHARDS is the shared cell for threads without a slot of their own
+class ShardedValue {
+    std::array<PaddedCell, SHARDS + 1> shards;
+
+public:
+    void add(int64_t n) {
+        int shard = shardIndex();
+        if (shard >= 0) ownedAdd(shards[shard].value, n);
+        else shards[SHARDS].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    int64_t value() const {
+        int64_t total = 0;
+        for (auto& shard : shards) total += shard.value.load(std::memory_order_relaxed);
+        return total;
+    }
+};
+
+class Counter {
+    ShardedValue total;
+
+public:
+    void inc(int64_t n = 1) { total.add(n); }
+    int64_t value() const { return total.value(); }
+};
+
+class Gauge {
+    ShardedValue total;
+
+public:
+    void add(int64_t delta) { total.add(delta); }
+    void sub(int64_t delta) { total.add(-delta); }
+
+    // not atomic with respect to concurrent add()s
+    void set(int64_t target) { total.add(target - value()); }
+
+    int64_t value() const { return total.value(); }
+};
+
+// ---- histogram ----
+
+// 16 sub-buckets per power of two, so any recorded value is reported within
+// 1/16 (6.25%) of itself; values are ticks up to 2^40 (about 6 minutes at
+// 3GHz), longer ones land in the last bucket
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB = 1 << SUB_BITS;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr int BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB;
+
+    static int bucketOf(uint64_t value) {
+        if (value < SUB) return (int)value;
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+        return (exponent - SUB_BITS + 1) * SUB + (int)((value >> (exponent - SUB_BITS)) & (SUB - 1));
+    }
+
+    // smallest value that lands in bucket
+    static uint64_t lowerBound(int bucket) {
+        if (bucket < SUB) return bucket;
+        int exponent = bucket / SUB + SUB_BITS - 1;
+        return uint64_t(SUB + bucket % SUB) << (exponent - SUB_BITS);
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count = 0;
+        uint64_t sum = 0;    // ticks
+
+        // in ticks: midpoint of the bucket holding the q-th value
+        double quantile(double q) const {
+            if (count == 0) return 0;
+            uint64_t rank = std::min<uint64_t>(count - 1, uint64_t(q * count));
+            uint64_t seen = 0;
+            for (int b = 0; b < BUCKETS; b++) {
+                seen += counts[b];
+                if (seen > rank) return (lowerBound(b) + (b + 1 < BUCKETS ? lowerBound(b + 1) : lowerBound(b))) / 2.0;
+            }
+            return lowerBound(BUCKETS - 1);
+        }
+    };
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+        std::atomic<uint64_t> sum{0};
+    };
+    std::array<Shard, SHARDS + 1> shards;
+
+public:
+    void record(uint64_t ticks) {
+        int index = shardIndex();
+        if (index >= 0) {
+            ownedAdd(shards[index].counts[bucketOf(ticks)], 1);
+            ownedAdd(shards[index].sum, ticks);
+        } else {
+            shards[SHARDS].counts[bucketOf(ticks)].fetch_add(1, std::memory_order_relaxed);
+            shards[SHARDS].sum.fetch_add(ticks, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot result;
+        result.counts.assign(BUCKETS, 0);
+        for (auto& shard : shards) {
+            for (int b = 0; b < BUCKETS; b++) {
+                uint64_t n = shard.counts[b].load(std::memory_order_relaxed);
+                result.counts[b] += n;
+                result.count += n;
+            }
+            result.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+};
+
+// records the lifetime of the scope into a histogram
+class ScopedTimer {
+    Histogram& histogram;
+    uint64_t start;
+
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram(histogram), start(ticks()) {}
+    ~ScopedTimer() { histogram.record(ticks() - start); }
+};
+
+// ---- registry ----
+
+class Registry {
+    enum class Kind { COUNTER, GAUGE, GAUGE_FUNCTION, HISTOGRAM };
+
+    struct Entry {
+        std::string labels;     // prometheus label body, e.g. outcome="ok"
+        Kind kind;
+        void* metric;
+        std::function<double()> read;
+    };
+
+    struct Family {
+        std::string help;
+        Kind kind;
+        std::vector<Entry> entries;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Family> families;
+    std::deque<Counter> counters;
+    std::deque<Gauge> gauges;
+    std::deque<Histogram> histograms;
+
+    template <typename T>
+    T& getOrCreate(std::deque<T>& storage, Kind kind, const std::string& name, const std::string& help,
+                   const std::string& labels) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Family& family = families[name];
+        if (family.entries.empty()) {
+            family.help = help;
+            family.kind = kind;
+        }
+        for (auto& entry : family.entries) {
+            if (entry.labels == labels) return *static_cast<T*>(entry.metric);
+        }
+        storage.emplace_back();
+        family.entries.push_back(Entry{labels, kind, &storage.back(), nullptr});
+        return storage.back();
+    }
+
+    static void writeSample(std::ostream& out, const std::string& name, const std::string& labels, double value) {
+        out << name;
+        if (!labels.empty()) out << '{' << labels << '}';
+        out << ' ' << value << '\n';
+    }
+
+public:
+    static Registry& global() {
+        static Registry registry;
+        return registry;
+    }
+
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return getOrCreate(counters, Kind::COUNTER, name, help, labels);
+    }
+
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return getOrCreate(gauges, Kind::GAUGE, name, help, labels);
+    }
+
+    // latencies are exported in seconds
+    Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return getOrCreate(histograms, Kind::HISTOGRAM, name, help, labels);
+    }
+
+    // value read at export time, for state a component already tracks
+    void gaugeFunction(const std::string& name, const std::string& help, std::function<double()> read,
+                       const std::string& labels = "") {
+        std::lock_guard<std::mutex> lock(mutex);
+        Family& family = families[name];
+        family.help = help;
+        family.kind = Kind::GAUGE_FUNCTION;
+        for (auto& entry : family.entries) {
+            if (entry.labels == labels) {
+                entry.read = std::move(read);
+                return;
+            }
+        }
+        family.entries.push_back(Entry{labels, Kind::GAUGE_FUNCTION, nullptr, std::move(read)});
+    }
+
+    // prometheus text exposition format 0.0.4; histograms as summaries
+    void writePrometheus(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        double secondsPerTick = nanosPerTick() / 1e9;
+        for (auto& [name, family] : families) {
+            const char* type = family.kind == Kind::COUNTER ? "counter"
+                             : family.kind == Kind::HISTOGRAM ? "summary" : "gauge";
+            out << "# HELP " << name << ' ' << family.help << '\n';
+            out << "# TYPE " << name << ' ' << type << '\n';
+            for (auto& entry : family.entries) {
+                switch (entry.kind) {
+                    case Kind::COUNTER:
+                        writeSample(out, name, entry.labels, double(static_cast<Counter*>(entry.metric)->value()));
+                        break;
+                    case Kind::GAUGE:
+                        writeSample(out, name, entry.labels, double(static_cast<Gauge*>(entry.metric)->value()));
+                        break;
+                    case Kind::GAUGE_FUNCTION:
+                        writeSample(out, name, entry.labels, entry.read());
+                        break;
+                    case Kind::HISTOGRAM: {
+                        Histogram::Snapshot snapshot = static_cast<Histogram*>(entry.metric)->snapshot();
+                        std::string prefix = entry.labels.empty() ? "" : entry.labels + ",";
+                        for (const char* q : {"0.5", "0.9", "0.99", "0.999"}) {
+                            writeSample(out, name, prefix + "quantile=\"" + q + "\"",
+                                        snapshot.quantile(std::stod(q)) * secondsPerTick);
+                        }
+                        writeSample(out, name + "_sum", entry.labels, snapshot.sum * secondsPerTick);
+                        writeSample(out, name + "_count", entry.labels, double(snapshot.count));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    std::string prometheusText() {
+        std::ostringstream out;
+        writePrometheus(out);
+        return out.str();
+    }
+};
+
+// ---- exporter ----
+
+// background thread that publishes a registry: either rewrites a file every
+// interval (write to path.tmp, then rename, so readers never see half a
+// file) or answers every HTTP connection on 127.0.0.1:port with the text
+class PrometheusExporter {
+    Registry& registry;
+    std::atomic<bool> running{true};
+    std::mutex waitMutex;
+    std::condition_variable wake;
+    std::thread worker;
+    int listenFd = -1;
+
+    void fileLoop(const std::string& path, std::chrono::milliseconds interval) {
+        while (running.load()) {
+            writeFile(path);
+            std::unique_lock<std::mutex> lock(waitMutex);
+            wake.wait_for(lock, interval, [this]() { return !running.load(); });
+        }
+        writeFile(path);
+    }
+
+    void httpLoop() {
+        while (running.load()) {
+            pollfd pending{listenFd, POLLIN, 0};
+            if (poll(&pending, 1, 100) <= 0) continue;
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client < 0) continue;
+            char request[1024];
+            (void)!read(client, request, sizeof(request));
+            std::string body = registry.prometheusText();
+            std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                                   std::to_string(body.size()) + "\r\n\r\n" + body;
+            size_t sent = 0;
+            while (sent < response.size()) {
+                ssize_t n = write(client, response.data() + sent, response.size() - sent);
+                if (n <= 0) break;
+                sent += n;
+            }
+            close(client);
+        }
+    }
+
+public:
+    PrometheusExporter(Registry& registry, const std::string& path, std::chrono::milliseconds interval)
+        : registry(registry) {
+        worker = std::thread(&PrometheusExporter::fileLoop, this, path, interval);
+    }
+
+    // port 0 picks a free port; see getPort()
+    PrometheusExporter(Registry& registry, uint16_t port) : registry(registry) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd, 16) < 0) {
+            if (listenFd >= 0) close(listenFd);
+            throw std::runtime_error("metrics exporter cannot listen on port " + std::to_string(port));
+        }
+        worker = std::thread(&PrometheusExporter::httpLoop, this);
+    }
+
+    ~PrometheusExporter() {
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            running.store(false);
+        }
+        wake.notify_all();
+        worker.join();
+        if (listenFd >= 0) close(listenFd);
+    }
+
+    uint16_t getPort() const {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, (sockaddr*)&address, &length);
+        return ntohs(address.sin_port);
+    }
+
+    void writeFile(const std::string& path) {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            registry.writePrometheus(out);
+        }
+        std::rename(temporary.c_str(), path.c_str());
+    }
+};
+
+// ---- overhead check ----
+
+struct Overhead {
+    double counterNanos;
+    double timerNanos;      // ScopedTimer: two ticks() + histogram record
+    double tickNanos;       // one ticks() alone, the floor under timerNanos
+};
+
+// average hot-path cost per event on the calling thread
+inline Overhead measureOverhead(int events = 1000000) {
+    Counter counter;
+    Histogram histogram;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < events; i++) counter.inc();
+    double counterNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < events; i++) ScopedTimer timer(histogram);
+    double timerNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    uint64_t sink = 0;
+    for (int i = 0; i < events; i++) sink += ticks();
+    double tickNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    counter.inc(sink & 1);
+    return Overhead{counterNanos / events, timerNanos / events, tickNanos / events};
+}
+
+}  // namespace metrics
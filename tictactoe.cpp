@@ -34,16 +34,19 @@ class Player{
 class Board{
     protected:
     int n;
+    int rows;
+    int cols;
     vector<vector<Symbol>>grid;
     
     public:
-    Board(int n) : n(n), grid(n, vector<Symbol>(n, Symbol::EMPTY)) {}
+    Board(int n) : Board(n, n) {}
+    Board(int rows, int cols) : n(rows), rows(rows), cols(cols), grid(rows, vector<Symbol>(cols, Symbol::EMPTY)) {}
     
     bool canPlace(int row,int col){
-        if(row<0 or row>=n or col<0 or col>=n)return false;
+        if(row<0 or row>=rows or col<0 or col>=cols)return false;
         return grid[row][col]==Symbol::EMPTY;
     }
-    void place(int row,int col, Symbol symbol){
+    virtual void place(int row,int col, Symbol symbol){
         if(!canPlace(row,col)){
             cout<<"cannot place symbol here:";
             return;
@@ -52,19 +55,48 @@ class Board{
         grid[row][col]=symbol;
     }
     
+    // side of a square board; use getRows/getCols for M x N boards
     int getSize(){
         return n;
     }
+    
+    int getRows(){
+        return rows;
+    }
+    
+    int getCols(){
+        return cols;
+    }
 
     const vector<vector<Symbol>>& getGrid(){
         return grid;
         
     }
+    
+    // empties every cell so the board can be reused for another game
+    virtual void clear(){
+        for(auto &row:grid) fill(row.begin(),row.end(),Symbol::EMPTY);
+    }
+    
+    virtual ~Board() = default;
 };
 
 class WinningStrategy{
     public:
     virtual bool checkWinner(Board &board,Symbol symbol,int row,int col)=0;
+    
+    // called after a move that did not win
+    virtual bool isDraw(Board &board,int movesPlayed){
+        return movesPlayed==board.getRows()*board.getCols();
+    }
+    
+    // strategies that keep per-game state start over
+    virtual void reset(){}
+    
+    // fresh copy for one game: Game plays on its own clone, so a strategy
+    // with per-game state can be handed to any number of games
+    virtual unique_ptr<WinningStrategy> clone() const = 0;
+    
     virtual ~WinningStrategy() = default;
     
 };
@@ -116,51 +148,1597 @@ class NXNWinningstrategy:public WinningStrategy{
         return false;
     }
     
+    unique_ptr<WinningStrategy> clone() const override{
+        return make_unique<NXNWinningstrategy>();
+    }
+    
 };
 
 
+// classic "n in a row on n x n": per player counters for every row, column
+// and both diagonals, so each move is O(1). must see every move of a game
+// exactly once: Game gives each game its own clone, anyone driving it by
+// hand calls reset() between games.
+// a line holding both symbols can never be won; once every line is dead
+// the game is a draw even if cells are still empty
+class CounterWinningStrategy:public WinningStrategy{
+    int n = 0;
+    // [player][line]: lines are rows 0..n-1, cols n..2n-1, diag 2n, anti 2n+1
+    vector<int> counts[2];
+    vector<uint8_t> owners;     // bit per player that has a symbol on the line
+    int deadLines = 0;
+    
+    void mark(int player,int line){
+        counts[player][line]++;
+        if(owners[line]==3) return;
+        owners[line] |= 1<<player;
+        if(owners[line]==3) deadLines++;
+    }
+    
+    public:
+    bool checkWinner(Board &board,Symbol symbol,int row,int col)override{
+        if(n!=board.getSize()){
+            n = board.getSize();
+            reset();
+        }
+        int player = symbol==Symbol::X ? 0 : 1;
+        mark(player,row);
+        mark(player,n+col);
+        if(row==col) mark(player,2*n);
+        if(row+col==n-1) mark(player,2*n+1);
+        
+        return counts[player][row]==n or counts[player][n+col]==n or
+               (row==col and counts[player][2*n]==n) or
+               (row+col==n-1 and counts[player][2*n+1]==n);
+    }
+    
+    bool isDraw(Board &board,int movesPlayed)override{
+        return deadLines==2*n+2 or WinningStrategy::isDraw(board,movesPlayed);
+    }
+    
+    void reset()override{
+        for(auto &c:counts) c.assign(2*n+2,0);
+        owners.assign(2*n+2,0);
+        deadLines = 0;
+    }
+    
+    unique_ptr<WinningStrategy> clone() const override{
+        return make_unique<CounterWinningStrategy>();
+    }
+};
+
+
+// k in a row on any rows x cols board (gomoku style): from the new stone,
+// walk outward both ways along each of the 4 directions, O(k) per move
+class KInARowWinningStrategy:public WinningStrategy{
+    int k;
+    
+    public:
+    KInARowWinningStrategy(int k):k(k){}
+    
+    bool checkWinner(Board &board,Symbol symbol,int row,int col)override{
+        const auto &grid = board.getGrid();
+        int rows = board.getRows(), cols = board.getCols();
+        static const int directions[4][2] = {{0,1},{1,0},{1,1},{1,-1}};
+        for(auto &d:directions){
+            int count = 1;
+            for(int sign=-1;sign<=1;sign+=2){
+                int r = row+sign*d[0], c = col+sign*d[1];
+                while(count<k and r>=0 and r<rows and c>=0 and c<cols and grid[r][c]==symbol){
+                    count++;
+                    r += sign*d[0];
+                    c += sign*d[1];
+                }
+            }
+            if(count>=k) return true;
+        }
+        return false;
+    }
+    
+    unique_ptr<WinningStrategy> clone() const override{
+        return make_unique<KInARowWinningStrategy>(k);
+    }
+};
+
+
+/******************************************************************************
+Bitboard + search engine
+
+BitBoard keeps one bit mask per player next to the grid, sized for the
+board (19 x 19 and larger fit). every possible k-cell line is precomputed
+as its cell list, and each cell knows the lines through it, so "did this
+move win" is a few bit tests per line.
+
+SearchEngine runs negamax with alpha-beta on a BitBoard: Zobrist hashed
+transposition table, TT move first then a cheap positional ordering, and
+iterative deepening that returns the best move of the last finished depth
+once the time or node budget runs out. with threads > 1 it runs Lazy SMP:
+every thread searches the same root against one lock-free table.
+*******************************************************************************/
+
+// one bit per board cell, sized for the board it is built for
+struct CellMask{
+    vector<uint64_t> words;
+    
+    explicit CellMask(int cells = 0):words((cells+63)/64){}
+    
+    void set(int cell){ words[cell>>6] |= 1ull<<(cell&63); }
+    void clear(int cell){ words[cell>>6] &= ~(1ull<<(cell&63)); }
+    bool test(int cell) const{ return words[cell>>6]>>(cell&63)&1; }
+    void reset(){ fill(words.begin(),words.end(),0); }
+};
+
+// every k-in-a-row line of a rows x cols board, shared by all boards of
+// that shape. a line is its k cells, stored flat: line i is
+// lineCells[i*k .. i*k+k), so checks cost k bit tests whatever the board size
+struct WinTable{
+    // the transposition table keeps best moves as int16
+    static const int MAX_CELLS = INT16_MAX;
+    
+    int rows, cols, k;
+    vector<int> lineCells;
+    vector<vector<int>> linesThroughCell;
+    // per shape keys: one per player and cell, a non-zero key for the empty
+    // board (a zeroed table slot must not match it) and one for O to move
+    vector<uint64_t> zobrist[2];
+    uint64_t emptyKey, oToMoveKey;
+    
+    WinTable(int rows,int cols,int k):rows(rows),cols(cols),k(k),linesThroughCell(rows*cols){
+        if(rows*cols>MAX_CELLS) throw invalid_argument("bitboard supports at most 32767 cells");
+        static const int directions[4][2] = {{0,1},{1,0},{1,1},{1,-1}};
+        for(int r=0;r<rows;r++){
+            for(int c=0;c<cols;c++){
+                for(auto &d:directions){
+                    int endRow = r+d[0]*(k-1), endCol = c+d[1]*(k-1);
+                    if(endRow<0 or endRow>=rows or endCol<0 or endCol>=cols) continue;
+                    int index = lineCount();
+                    for(int i=0;i<k;i++){
+                        int cell = (r+d[0]*i)*cols+(c+d[1]*i);
+                        lineCells.push_back(cell);
+                        linesThroughCell[cell].push_back(index);
+                    }
+                }
+            }
+        }
+        seed_seq seeds{0x5eed,rows,cols,k};
+        mt19937_64 rng(seeds);
+        for(auto &keys:zobrist){
+            keys.resize(rows*cols);
+            for(auto &key:keys) key = rng();
+        }
+        emptyKey = rng()|1;
+        oToMoveKey = rng();
+    }
+    
+    int lineCount() const{ return (int)lineCells.size()/k; }
+    
+    bool isFull(const CellMask &stones,int line) const{
+        const int *cells = &lineCells[line*k];
+        for(int i=0;i<k;i++){
+            if(!stones.test(cells[i])) return false;
+        }
+        return true;
+    }
+    
+    int countOn(const CellMask &stones,int line) const{
+        const int *cells = &lineCells[line*k];
+        int count = 0;
+        for(int i=0;i<k;i++) count += stones.test(cells[i]);
+        return count;
+    }
+    
+    static shared_ptr<const WinTable> get(int rows,int cols,int k){
+        static mutex cacheMutex;
+        static map<tuple<int,int,int>,shared_ptr<const WinTable>> cache;
+        lock_guard<mutex> lock(cacheMutex);
+        auto &table = cache[{rows,cols,k}];
+        if(!table) table = make_shared<WinTable>(rows,cols,k);
+        return table;
+    }
+};
+
+// shapes the k-in-a-row code accepts from outside: a non-empty board, a
+// line that fits on it, and at most MAX_CELLS cells, so rows and cols fit
+// the int16 session commands and every cell fits a uint16 move log entry
+inline bool isValidShape(int64_t rows,int64_t cols,int64_t k){
+    return rows>=1 and cols>=1 and rows<=WinTable::MAX_CELLS and cols<=WinTable::MAX_CELLS and
+           k>=1 and k<=max(rows,cols) and rows*cols<=WinTable::MAX_CELLS;
+}
+
+class BitBoard:public Board{
+    shared_ptr<const WinTable> table;
+    CellMask stones[2];
+    uint64_t hash;
+    int empty;
+    
+    public:
+    static int playerOf(Symbol symbol){
+        return symbol==Symbol::X ? 0 : 1;
+    }
+    
+    BitBoard(int rows,int cols,int k):Board(rows,cols),table(WinTable::get(rows,cols,k)),
+        stones{CellMask(rows*cols),CellMask(rows*cols)},hash(table->emptyKey),empty(rows*cols){}
+    
+    // copies a grid board's position
+    BitBoard(Board &board,int k):BitBoard(board.getRows(),board.getCols(),k){
+        const auto &source = board.getGrid();
+        for(int r=0;r<rows;r++){
+            for(int c=0;c<cols;c++){
+                if(source[r][c]!=Symbol::EMPTY) place(r,c,source[r][c]);
+            }
+        }
+    }
+    
+    void place(int row,int col,Symbol symbol)override{
+        if(!canPlace(row,col)){
+            cout<<"cannot place symbol here:";
+            return;
+        }
+        grid[row][col]=symbol;
+        makeMove(row*cols+col,playerOf(symbol));
+    }
+    
+    // search-only moves: masks and hash, the grid is left untouched
+    void makeMove(int cell,int player){
+        stones[player].set(cell);
+        hash ^= table->zobrist[player][cell];
+        empty--;
+    }
+    
+    void undoMove(int cell,int player){
+        stones[player].clear(cell);
+        hash ^= table->zobrist[player][cell];
+        empty++;
+    }
+    
+    void clear()override{
+        Board::clear();
+        stones[0].reset();
+        stones[1].reset();
+        hash = table->emptyKey;
+        empty = rows*cols;
+    }
+    
+    bool isEmptyCell(int cell) const{
+        return !stones[0].test(cell) and !stones[1].test(cell);
+    }
+    
+    bool isWin(int player,int cell) const{
+        for(int line:table->linesThroughCell[cell]){
+            if(table->isFull(stones[player],line)) return true;
+        }
+        return false;
+    }
+    
+    const CellMask& getStones(int player) const{ return stones[player]; }
+    const WinTable& getTable() const{ return *table; }
+    // the stones only; SearchEngine adds whose turn it is
+    uint64_t getHash() const{ return hash; }
+    int getEmptyCount() const{ return empty; }
+    int getCellCount() const{ return rows*cols; }
+    int getColCount() const{ return cols; }
+};
+
+struct SearchResult{
+    int row = -1, col = -1;
+    int score = 0;          // from the mover's side: >0 winning, <0 losing
+    int depth = 0;          // last fully searched depth
+    uint64_t nodes = 0;
+    chrono::microseconds elapsed{0};
+    
+    double nodesPerSecond() const{
+        return elapsed.count() ? nodes*1e6/elapsed.count() : 0;
+    }
+};
+
+struct SearchLimits{
+    chrono::milliseconds time{1000};
+    uint64_t maxNodes = 0;      // 0 = no node budget
+    int maxDepth = 64;
+    int threads = 1;
+};
+
+class SearchEngine{
+    public:
+    static const int WIN = 1000000;
+    
+    protected:
+    enum Bound : uint8_t{ EXACT, LOWER, UPPER };
+    
+    struct TTEntry{
+        int32_t score = 0;
+        int16_t bestMove = -1;
+        int8_t depth = -1;
+        Bound bound = EXACT;
+    };
+    
+    // lock-free slot shared by all search threads: the check word holds
+    // key ^ data, so a torn write from two racing stores fails the key
+    // test on probe instead of returning a mixed entry
+    struct TTSlot{
+        atomic<uint64_t> check{0};
+        atomic<uint64_t> data{0};
+    };
+    
+    // per-thread search state: own board copy, own node count
+    struct Worker{
+        int id;
+        BitBoard board;
+        uint64_t nodes = 0;
+        SearchResult result;
+        
+        Worker(int id,Board &source,int k):id(id),board(source,k){}
+    };
+    
+    int k;
+    unique_ptr<TTSlot[]> table;
+    size_t tableMask;
+    atomic<bool> stop{false};
+    atomic<uint64_t> sharedNodes{0};
+    uint64_t maxNodes = 0;
+    chrono::steady_clock::time_point deadline;
+    
+    static int toTable(int score,int ply){
+        return score>WIN-1000 ? score+ply : score<-WIN+1000 ? score-ply : score;
+    }
+    static int fromTable(int score,int ply){
+        return score>WIN-1000 ? score-ply : score<-WIN+1000 ? score+ply : score;
+    }
+    
+    bool probe(uint64_t key,TTEntry &entry) const{
+        TTSlot &slot = table[key&tableMask];
+        uint64_t data = slot.data.load(memory_order_relaxed);
+        uint64_t check = slot.check.load(memory_order_relaxed);
+        if((check^data)!=key) return false;
+        entry.score = (int32_t)(uint32_t)data;
+        entry.bestMove = (int16_t)(uint16_t)(data>>32);
+        entry.depth = (int8_t)(uint8_t)(data>>48);
+        entry.bound = (Bound)(data>>56);
+        return true;
+    }
+    
+    void store(uint64_t key,const TTEntry &entry){
+        uint64_t data = (uint64_t)(uint32_t)entry.score
+                      | (uint64_t)(uint16_t)entry.bestMove<<32
+                      | (uint64_t)(uint8_t)entry.depth<<48
+                      | (uint64_t)entry.bound<<56;
+        TTSlot &slot = table[key&tableMask];
+        slot.data.store(data,memory_order_relaxed);
+        slot.check.store(key^data,memory_order_relaxed);
+    }
+    
+    // search() may be asked for either side in one position, so the table
+    // key is the stones plus the side to move
+    static uint64_t keyOf(const BitBoard &board,int player){
+        return player ? board.getHash()^board.getTable().oToMoveKey : board.getHash();
+    }
+    
+    // 4^stones, capped so long lines cannot overflow
+    static int64_t weight(int stones){
+        return 1ll<<(2*min(stones,20));
+    }
+    
+    // lines only one side can still complete, weighted by how full they are;
+    // clamped below the mate range so it never reads as a forced result
+    int evaluate(const BitBoard &board,int player) const{
+        const WinTable &wins = board.getTable();
+        int64_t score = 0;
+        for(int line=0;line<wins.lineCount();line++){
+            int mine = wins.countOn(board.getStones(player),line);
+            int theirs = wins.countOn(board.getStones(1-player),line);
+            if(mine>0 and theirs==0) score += weight(mine);
+            else if(theirs>0 and mine==0) score -= weight(theirs);
+        }
+        return (int)clamp<int64_t>(score,-(WIN-1001),WIN-1001);
+    }
+    
+    // empty cells, near existing stones on big boards; ttMove first, then
+    // cells that win / block, then cells touching more stones, then central
+    vector<int> orderedMoves(BitBoard &board,int player,int ttMove) const{
+        int cells = board.getCellCount(), cols = board.getColCount(), rows = cells/cols;
+        bool local = cells>25 and board.getEmptyCount()<cells;
+        vector<pair<int,int>> scored;
+        for(int cell=0;cell<cells;cell++){
+            if(!board.isEmptyCell(cell)) continue;
+            int r = cell/cols, c = cell%cols, neighbours = 0;
+            for(int dr=-2;dr<=2;dr++){
+                for(int dc=-2;dc<=2;dc++){
+                    int nr = r+dr, nc = c+dc;
+                    if((dr or dc) and nr>=0 and nr<rows and nc>=0 and nc<cols and !board.isEmptyCell(nr*cols+nc)){
+                        neighbours += (abs(dr)<=1 and abs(dc)<=1) ? 2 : 1;
+                    }
+                }
+            }
+            if(local and neighbours==0) continue;
+            int centrality = -(abs(2*r-rows+1)+abs(2*c-cols+1));
+            int priority = neighbours*16+centrality;
+            if(cell==ttMove) priority = INT_MAX;
+            scored.push_back({priority,cell});
+        }
+        sort(scored.begin(),scored.end(),greater<>());
+        vector<int> moves;
+        for(auto &entry:scored) moves.push_back(entry.second);
+        // an immediate win or a forced block goes before everything else
+        for(int side:{player,1-player}){
+            for(size_t i=0;i<moves.size();i++){
+                board.makeMove(moves[i],side);
+                bool wins = board.isWin(side,moves[i]);
+                board.undoMove(moves[i],side);
+                if(wins){
+                    rotate(moves.begin(),moves.begin()+i,moves.begin()+i+1);
+                    return moves;
+                }
+            }
+        }
+        return moves;
+    }
+    
+    // clock and node budget are checked every 1024 nodes per thread
+    bool shouldStop(Worker &worker){
+        if((++worker.nodes&1023)==0){
+            uint64_t total = sharedNodes.fetch_add(1024,memory_order_relaxed)+1024;
+            if(chrono::steady_clock::now()>=deadline or (maxNodes and total>=maxNodes)){
+                stop.store(true,memory_order_relaxed);
+            }
+        }
+        return stop.load(memory_order_relaxed);
+    }
+    
+    int negamax(Worker &worker,int depth,int alpha,int beta,int player,int ply){
+        if(shouldStop(worker)) return 0;
+        BitBoard &board = worker.board;
+        if(board.getEmptyCount()==0) return 0;
+        
+        TTEntry entry;
+        int ttMove = -1;
+        uint64_t key = keyOf(board,player);
+        if(probe(key,entry)){
+            ttMove = entry.bestMove;
+            if(entry.depth>=depth){
+                int score = fromTable(entry.score,ply);
+                if(entry.bound==EXACT) return score;
+                if(entry.bound==LOWER) alpha = max(alpha,score);
+                else beta = min(beta,score);
+                if(alpha>=beta) return score;
+            }
+        }
+        if(depth==0) return evaluate(board,player);
+        
+        int originalAlpha = alpha, best = -WIN-1, bestMove = -1;
+        for(int move:orderedMoves(board,player,ttMove)){
+            board.makeMove(move,player);
+            int score = board.isWin(player,move) ? WIN-ply
+                      : -negamax(worker,depth-1,-beta,-alpha,1-player,ply+1);
+            board.undoMove(move,player);
+            if(stop.load(memory_order_relaxed)) return 0;
+            if(score>best){
+                best = score;
+                bestMove = move;
+            }
+            alpha = max(alpha,score);
+            if(alpha>=beta) break;
+        }
+        
+        entry.score = toTable(best,ply);
+        entry.depth = (int8_t)depth;
+        entry.bestMove = (int16_t)bestMove;
+        entry.bound = best<=originalAlpha ? UPPER : best>=beta ? LOWER : EXACT;
+        store(key,entry);
+        return best;
+    }
+    
+    // iterative deepening on one thread. helpers (id > 0) are Lazy SMP:
+    // odd ids start one ply deeper and every helper rotates its root move
+    // order, so the threads fill the shared table with different subtrees
+    void searchRoot(Worker &worker,int player,int maxDepth){
+        BitBoard &root = worker.board;
+        int cols = root.getColCount();
+        SearchResult &result = worker.result;
+        for(int depth=1+(worker.id&1);depth<=min(maxDepth,root.getEmptyCount());depth++){
+            TTEntry entry;
+            int ttMove = probe(keyOf(root,player),entry) ? entry.bestMove : result.row*cols+result.col;
+            vector<int> moves = orderedMoves(root,player,ttMove);
+            if(worker.id>0 and moves.size()>1){
+                size_t shift = 1+worker.id%(moves.size()-1);
+                rotate(moves.begin()+1,moves.begin()+min(moves.size()-1,shift),moves.end());
+            }
+            int alpha = -WIN-1, best = -WIN-1, bestMove = -1;
+            for(int move:moves){
+                root.makeMove(move,player);
+                int score = root.isWin(player,move) ? WIN
+                          : -negamax(worker,depth-1,-WIN-1,-alpha,1-player,1);
+                root.undoMove(move,player);
+                if(stop.load(memory_order_relaxed)) break;
+                if(score>best){
+                    best = score;
+                    bestMove = move;
+                }
+                alpha = max(alpha,score);
+            }
+            if(stop.load(memory_order_relaxed) or bestMove<0) break;
+            result.row = bestMove/cols;
+            result.col = bestMove%cols;
+            result.score = best;
+            result.depth = depth;
+            if(abs(best)>WIN-1000) break;   // forced result found
+        }
+    }
+    
+    public:
+    // ttSize is rounded down to a power of two
+    SearchEngine(int k,size_t ttSize = 1<<20):k(k){
+        size_t size = 1;
+        while(size*2<=ttSize) size *= 2;
+        table = make_unique<TTSlot[]>(size);
+        tableMask = size-1;
+    }
+    
+    // best move for symbol in board's position within limits; the deepest
+    // finished iteration over all threads wins, ties go to the main thread
+    SearchResult search(Board &board,Symbol symbol,const SearchLimits &limits){
+        auto start = chrono::steady_clock::now();
+        int player = BitBoard::playerOf(symbol);
+        deadline = start+limits.time;
+        maxNodes = limits.maxNodes;
+        sharedNodes = 0;
+        stop = false;
+        
+        vector<unique_ptr<Worker>> workers;
+        for(int i=0;i<max(1,limits.threads);i++) workers.push_back(make_unique<Worker>(i,board,k));
+        vector<thread> helpers;
+        for(size_t i=1;i<workers.size();i++){
+            helpers.emplace_back([this,&workers,i,player,&limits](){
+                searchRoot(*workers[i],player,limits.maxDepth);
+            });
+        }
+        searchRoot(*workers[0],player,limits.maxDepth);
+        stop = true;
+        for(auto &helper:helpers) helper.join();
+        
+        SearchResult result = workers[0]->result;
+        uint64_t nodes = 0;
+        for(auto &worker:workers){
+            nodes += worker->nodes;
+            if(worker->result.depth>result.depth) result = worker->result;
+        }
+        // nothing finished in time: fall back to the best ordered move
+        BitBoard &root = workers[0]->board;
+        if(result.row<0 and root.getEmptyCount()>0){
+            int move = orderedMoves(root,player,-1).front();
+            result.row = move/root.getColCount();
+            result.col = move%root.getColCount();
+        }
+        result.nodes = nodes;
+        result.elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now()-start);
+        return result;
+    }
+    
+    SearchResult search(Board &board,Symbol symbol,chrono::milliseconds budget,int maxDepth = 64){
+        SearchLimits limits;
+        limits.time = budget;
+        limits.maxDepth = maxDepth;
+        return search(board,symbol,limits);
+    }
+};
+
+
+enum class MoveStatus{
+    OK,
+    INVALID,
+    WIN,
+    DRAW,
+    FINISHED    // game already won or drawn
+};
+
 class Game{
     Board board;
-    queue<Player>players;
-    WinningStrategy *winningStrategy;
+    array<Player,2> players;
+    int turn;
+    unique_ptr<WinningStrategy> winningStrategy;    // this game's own clone
     int movesPlayed;
+    bool finished;
+    Symbol winner;
+    vector<uint16_t> history;   // row*cols+col per move, for move logs (MoveLogWriter takes only shapes whose cells fit)
     
     public:
-    Game(int size,Player& p1,Player& p2,WinningStrategy& strategy): board(size), winningStrategy(&strategy),movesPlayed(0){
-    players.push(p1);
-    players.push(p2);
+    Game(int size,Player& p1,Player& p2,WinningStrategy& strategy): Game(size,size,p1,p2,strategy) {}
+    
+    Game(int rows,int cols,Player& p1,Player& p2,WinningStrategy& strategy): board(rows,cols), players{p1,p2}, turn(0), winningStrategy(strategy.clone()),movesPlayed(0),finished(false),winner(Symbol::EMPTY){}
+    
+    // plays the move for the player to move and reports what happened,
+    // without printing
+    MoveStatus applyMove(int row,int col){
+        if(finished) return MoveStatus::FINISHED;
+        if(!board.canPlace(row,col)) return MoveStatus::INVALID;
+        Symbol symbol = players[turn].getSymbol();
+        board.place(row,col,symbol);
+        movesPlayed++;
+        history.push_back((uint16_t)(row*board.getCols()+col));
+        
+        if(winningStrategy->checkWinner(board,symbol,row,col)){
+            finished = true;
+            winner = symbol;
+            return MoveStatus::WIN;
+        }
+        if(winningStrategy->isDraw(board,movesPlayed)){
+            finished = true;
+            return MoveStatus::DRAW;
+        }
+        turn ^= 1;
+        return MoveStatus::OK;
     }
     
     void playMove(int row,int col){
-        auto currentPlayer = players.front();
+        Player &currentPlayer = players[turn];
+        switch(applyMove(row,col)){
+            case MoveStatus::INVALID:
+                cout<<"invalid move:"<<endl;
+                break;
+            case MoveStatus::WIN:
+                cout<<"Player "<<currentPlayer.getName()<<" won"<<endl;
+                break;
+            case MoveStatus::DRAW:
+                cout<<"game draw:"<<endl;
+                break;
+            case MoveStatus::FINISHED:
+                cout<<"game over:"<<endl;
+                break;
+            case MoveStatus::OK:
+                break;
+        }
+    }
+    
+    Symbol currentSymbol(){
+        return players[turn].getSymbol();
+    }
+    
+    int getMovesPlayed(){
+        return movesPlayed;
+    }
+    
+    bool isFinished(){
+        return finished;
+    }
+    
+    // EMPTY while playing or after a draw
+    Symbol getWinner(){
+        return winner;
+    }
+    
+    const vector<uint16_t>& getHistory(){
+        return history;
+    }
+    
+    Board& getBoard(){
+        return board;
+    }
+    
+    // suggested move for the player to move, within budget
+    SearchResult hint(SearchEngine &engine,const SearchLimits &limits){
+        return engine.search(board,currentSymbol(),limits);
+    }
+    
+    // AI opponent: the player to move plays the engine's choice
+    SearchResult playComputerMove(SearchEngine &engine,const SearchLimits &limits){
+        SearchResult result = hint(engine,limits);
+        if(result.row>=0) playMove(result.row,result.col);
+        return result;
+    }
+
+    
+};
+
+
+/******************************************************************************
+Game session server
+
+sessions are spread over shards; each shard has one worker thread that
+owns its slab of games outright, so games are never locked. clients talk
+to a shard through a bounded lock-free MPSC queue and get results back as
+MoveEvents on the sink (called on the worker thread). a session id packs
+generation | shard | slot, so a move for an evicted session is detected
+instead of landing in the game that reused the slot. finished games are
+evicted as soon as they end.
+*******************************************************************************/
+
+// bounded multi-producer single-consumer ring (Vyukov): a per-cell
+// sequence number tells producers and the consumer whose turn it is
+template<typename T>
+class MpscQueue{
+    struct Cell{
+        atomic<size_t> sequence;
+        T value;
+    };
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;
+    
+    public:
+    // capacity is rounded up to a power of two
+    MpscQueue(size_t capacity){
+        size_t size = 1;
+        while(size<capacity) size *= 2;
+        cells = make_unique<Cell[]>(size);
+        mask = size-1;
+        for(size_t i=0;i<size;i++) cells[i].sequence.store(i,memory_order_relaxed);
+    }
+    
+    bool tryPush(const T &value){
+        size_t position = tail.load(memory_order_relaxed);
+        while(true){
+            Cell &cell = cells[position&mask];
+            intptr_t diff = (intptr_t)cell.sequence.load(memory_order_acquire)-(intptr_t)position;
+            if(diff==0){
+                if(tail.compare_exchange_weak(position,position+1,memory_order_relaxed)){
+                    cell.value = value;
+                    cell.sequence.store(position+1,memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff<0) return false;   // full
+            else position = tail.load(memory_order_relaxed);
+        }
+    }
+    
+    // consumer thread only
+    bool tryPop(T &value){
+        Cell &cell = cells[head&mask];
+        if(cell.sequence.load(memory_order_acquire)!=head+1) return false;
+        value = cell.value;
+        cell.sequence.store(head+mask+1,memory_order_release);
+        head++;
+        return true;
+    }
+};
+
+enum class SessionEventType : uint8_t{
+    MOVED,
+    CLOSED,
+    UNKNOWN_SESSION
+};
+
+struct MoveEvent{
+    uint64_t session;
+    uint64_t tag;               // echoed from submitMove
+    SessionEventType type;
+    MoveStatus status;
+    Symbol symbol;              // who moved
+    int row, col;
+    int moveNumber;
+    chrono::nanoseconds latency;    // submit to applied
+};
+
+struct SessionServerConfig{
+    int shards = 4;
+    uint32_t slotsPerShard = 16384;
+    size_t queueCapacity = 1<<16;
+    size_t batchSize = 256;     // commands per queue drain
+};
+
+class SessionServer{
+    public:
+    using EventSink = function<void(const MoveEvent&)>;
+    
+    private:
+    struct Command{
+        enum Type : uint8_t{ OPEN, MOVE, CLOSE } type;
+        uint64_t session;
+        uint64_t tag;
+        int16_t row, col, k;    // OPEN: row/col are the board shape
+        chrono::steady_clock::time_point submitted;
+    };
+    
+    struct Slot{
+        uint32_t generation = 1;
+        optional<Game> game;
+    };
+    
+    struct Shard{
+        MpscQueue<Command> queue;
+        vector<Slot> slots;                 // worker thread only
+        // rows<<16 | cols per slot, written by open() so submitMove can
+        // range check moves on the caller's thread; 0 = never opened
+        unique_ptr<atomic<uint32_t>[]> shapes;
+        mutex freeMutex;
+        vector<pair<uint32_t,uint32_t>> freeSlots;    // slot, generation
+        atomic<size_t> live{0};
+        atomic<bool> sleeping{false};
+        mutex wakeMutex;
+        condition_variable wake;
+        thread worker;
         
+        Shard(size_t capacity,uint32_t slotCount):queue(capacity),slots(slotCount),shapes(make_unique<atomic<uint32_t>[]>(slotCount)){
+            for(uint32_t i=slotCount;i-->0;) freeSlots.push_back({i,1});
+        }
+    };
+    
+    SessionServerConfig config;
+    EventSink sink;
+    vector<unique_ptr<Shard>> shards;
+    atomic<uint32_t> nextShard{0};
+    atomic<bool> stopping{false};
+    
+    static uint64_t makeId(uint32_t generation,uint32_t shard,uint32_t slot){
+        return (uint64_t)generation<<32 | shard<<24 | slot;
+    }
+    
+    void push(Shard &shard,const Command &command){
+        while(!shard.queue.tryPush(command)) this_thread::yield();
+        if(shard.sleeping.load()){
+            lock_guard<mutex> lock(shard.wakeMutex);
+            shard.wake.notify_one();
+        }
+    }
+    
+    void evict(Shard &shard,uint32_t slotIndex){
+        Slot &slot = shard.slots[slotIndex];
+        slot.game.reset();
+        slot.generation++;
+        shard.live--;
+        lock_guard<mutex> lock(shard.freeMutex);
+        shard.freeSlots.push_back({slotIndex,slot.generation});
+    }
+    
+    // ids come from callers and are not trusted: one that names no slot is
+    // answered on the sink, a stale generation is caught by the worker
+    bool validId(uint64_t session) const{
+        return shardOf(session)<shards.size() and (session&0xffffff)<config.slotsPerShard;
+    }
+    
+    void rejectUnknown(uint64_t session,uint64_t tag,int row,int col){
+        sink(MoveEvent{session,tag,SessionEventType::UNKNOWN_SESSION,MoveStatus::INVALID,Symbol::EMPTY,row,col,0,{}});
+    }
+    
+    void handle(Shard &shard,const Command &command){
+        uint32_t slotIndex = command.session&0xffffff;
+        Slot &slot = shard.slots[slotIndex];
+        MoveEvent event{command.session,command.tag,SessionEventType::MOVED,MoveStatus::OK,Symbol::EMPTY,command.row,command.col,0,{}};
         
-        if(!board.canPlace(row,col)){
-            cout<<"invalid move:"<<endl;
+        if(command.type==Command::OPEN){
+            static Player x(Symbol::X,"X"), o(Symbol::O,"O");
+            KInARowWinningStrategy strategy(command.k);
+            slot.game.emplace(command.row,command.col,x,o,strategy);
             return;
         }
-        players.pop();
-        board.place(row,col,currentPlayer.getSymbol());
-        movesPlayed++;
+        if(slot.generation!=command.session>>32 or !slot.game){
+            event.type = SessionEventType::UNKNOWN_SESSION;
+            event.status = MoveStatus::INVALID;
+        }
+        else if(command.type==Command::CLOSE){
+            event.type = SessionEventType::CLOSED;
+            evict(shard,slotIndex);
+        }
+        else{
+            Game &game = *slot.game;
+            event.symbol = game.currentSymbol();
+            event.status = game.applyMove(command.row,command.col);
+            event.moveNumber = game.getMovesPlayed();
+            if(game.isFinished()) evict(shard,slotIndex);
+        }
+        event.latency = chrono::steady_clock::now()-command.submitted;
+        sink(event);
+    }
+    
+    void run(Shard &shard){
+        Command command;
+        while(true){
+            size_t handled = 0;
+            while(handled<config.batchSize and shard.queue.tryPop(command)){
+                handle(shard,command);
+                handled++;
+            }
+            if(handled) continue;
+            if(stopping.load()) break;
+            // park; producers only take the lock when they see sleeping,
+            // and the timeout covers a wakeup lost in between
+            shard.sleeping.store(true);
+            if(shard.queue.tryPop(command)){
+                shard.sleeping.store(false);
+                handle(shard,command);
+                continue;
+            }
+            unique_lock<mutex> lock(shard.wakeMutex);
+            shard.wake.wait_for(lock,chrono::milliseconds(1));
+            shard.sleeping.store(false);
+        }
+    }
+    
+    public:
+    SessionServer(const SessionServerConfig &config,EventSink sink):config(config),sink(move(sink)){
+        if(config.shards<1 or config.shards>255 or config.slotsPerShard>(1u<<24)){
+            throw invalid_argument("bad session server config");
+        }
+        for(int i=0;i<config.shards;i++){
+            shards.push_back(make_unique<Shard>(config.queueCapacity,config.slotsPerShard));
+        }
+        for(auto &shard:shards){
+            Shard *target = shard.get();
+            shard->worker = thread([this,target](){ run(*target); });
+        }
+    }
+    
+    ~SessionServer(){
+        shutdown();
+    }
+    
+    // new k-in-a-row game; returns 0 when every shard is full or the shape
+    // fails isValidShape
+    uint64_t open(int rows,int cols,int k){
+        if(!isValidShape(rows,cols,k)) return 0;
+        for(int attempt=0;attempt<config.shards;attempt++){
+            uint32_t index = nextShard++%config.shards;
+            Shard &shard = *shards[index];
+            pair<uint32_t,uint32_t> free;
+            {
+                lock_guard<mutex> lock(shard.freeMutex);
+                if(shard.freeSlots.empty()) continue;
+                free = shard.freeSlots.back();
+                shard.freeSlots.pop_back();
+            }
+            shard.live++;
+            shard.shapes[free.first].store((uint32_t)rows<<16 | (uint32_t)cols,memory_order_relaxed);
+            uint64_t id = makeId(free.second,index,free.first);
+            push(shard,Command{Command::OPEN,id,0,(int16_t)rows,(int16_t)cols,(int16_t)k,chrono::steady_clock::now()});
+            return id;
+        }
+        return 0;
+    }
+    
+    // false when the shard's queue is full; the result arrives on the sink,
+    // UNKNOWN_SESSION for ids that were never issued or are no longer live,
+    // INVALID straight away for a cell off the session's board
+    bool submitMove(uint64_t session,int row,int col,uint64_t tag = 0){
+        if(!validId(session)){
+            rejectUnknown(session,tag,row,col);
+            return true;
+        }
+        Shard &shard = *shards[shardOf(session)];
+        uint32_t shape = shard.shapes[session&0xffffff].load(memory_order_relaxed);
+        if(shape==0){
+            rejectUnknown(session,tag,row,col);
+            return true;
+        }
+        if(row<0 or row>=(int)(shape>>16) or col<0 or col>=(int)(shape&0xffff)){
+            sink(MoveEvent{session,tag,SessionEventType::MOVED,MoveStatus::INVALID,Symbol::EMPTY,row,col,0,{}});
+            return true;
+        }
+        if(!shard.queue.tryPush(Command{Command::MOVE,session,tag,(int16_t)row,(int16_t)col,0,chrono::steady_clock::now()})){
+            return false;
+        }
+        if(shard.sleeping.load()){
+            lock_guard<mutex> lock(shard.wakeMutex);
+            shard.wake.notify_one();
+        }
+        return true;
+    }
+    
+    // drops an unfinished session
+    void close(uint64_t session){
+        if(!validId(session)){
+            rejectUnknown(session,0,0,0);
+            return;
+        }
+        push(*shards[shardOf(session)],Command{Command::CLOSE,session,0,0,0,0,chrono::steady_clock::now()});
+    }
+    
+    static uint32_t shardOf(uint64_t session){
+        return (session>>24)&0xff;
+    }
+    
+    size_t liveSessions() const{
+        size_t live = 0;
+        for(auto &shard:shards) live += shard->live.load();
+        return live;
+    }
+    
+    // drains the queues, then stops the workers
+    void shutdown(){
+        if(stopping.exchange(true)) return;
+        for(auto &shard:shards){
+            {
+                lock_guard<mutex> lock(shard->wakeMutex);
+                shard->wake.notify_one();
+            }
+            shard->worker.join();
+        }
+    }
+};
+
+
+/******************************************************************************
+Move logs, replay and self-play
+
+file layout ("TTM1"):
+    header   "TTM1", varint rows, cols, k
+    games    varint moveCount, byte result, varint cell per move
+    index    u64 offset of every game
+    footer   u64 gameCount, u64 indexOffset, "TTMI"
+cells are row*cols+col, so a 3x3 move is one byte and a 15x15 move at most
+two. result: 0 unfinished, 1 X won, 2 O won, 3 draw. integers in the index
+and footer are little endian.
+*******************************************************************************/
+
+enum GameResult : uint8_t{
+    UNFINISHED = 0,
+    X_WON = 1,
+    O_WON = 2,
+    DRAWN = 3
+};
+
+namespace movelog{
+    inline void putVarint(vector<uint8_t> &out,uint64_t value){
+        while(value>=0x80){
+            out.push_back((uint8_t)(value|0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+    
+    inline uint64_t getVarint(const uint8_t *&in,const uint8_t *end){
+        uint64_t value = 0;
+        for(int shift=0;in<end and shift<64;shift+=7){
+            uint8_t byte = *in++;
+            value |= (uint64_t)(byte&0x7f)<<shift;
+            if(!(byte&0x80)) return value;
+        }
+        throw runtime_error("truncated varint in move log");
+    }
+    
+    inline void putU64(vector<uint8_t> &out,uint64_t value){
+        for(int i=0;i<8;i++) out.push_back((uint8_t)(value>>(8*i)));
+    }
+    
+    inline uint64_t getU64(const uint8_t *in){
+        uint64_t value = 0;
+        for(int i=0;i<8;i++) value |= (uint64_t)in[i]<<(8*i);
+        return value;
+    }
+    
+    inline void encodeGame(vector<uint8_t> &out,const uint16_t *cells,size_t count,GameResult result){
+        putVarint(out,count);
+        out.push_back(result);
+        for(size_t i=0;i<count;i++) putVarint(out,cells[i]);
+    }
+    
+    inline GameResult resultOf(Game &game){
+        if(!game.isFinished()) return UNFINISHED;
+        if(game.getWinner()==Symbol::X) return X_WON;
+        if(game.getWinner()==Symbol::O) return O_WON;
+        return DRAWN;
+    }
+}
+
+// streams games to disk; the index is kept in memory and written by close()
+class MoveLogWriter{
+    ofstream out;
+    vector<uint8_t> buffer;
+    vector<uint64_t> offsets;
+    uint64_t written = 0;
+    int rows, cols;
+    
+    void flushBuffer(){
+        out.write((const char*)buffer.data(),buffer.size());
+        written += buffer.size();
+        buffer.clear();
+    }
+    
+    public:
+    // shapes outside isValidShape are refused: their cells would not fit
+    // the uint16 move entries
+    MoveLogWriter(const string &path,int rows,int cols,int k):rows(rows),cols(cols){
+        if(!isValidShape(rows,cols,k)) throw invalid_argument("board shape cannot be logged");
+        out.open(path,ios::binary|ios::trunc);
+        if(!out) throw runtime_error("cannot open move log "+path);
+        buffer.insert(buffer.end(),{'T','T','M','1'});
+        movelog::putVarint(buffer,rows);
+        movelog::putVarint(buffer,cols);
+        movelog::putVarint(buffer,k);
+    }
+    
+    ~MoveLogWriter(){
+        if(out.is_open()) close();
+    }
+    
+    void append(const uint16_t *cells,size_t count,GameResult result){
+        offsets.push_back(written+buffer.size());
+        movelog::encodeGame(buffer,cells,count,result);
+        if(buffer.size()>=1<<16) flushBuffer();
+    }
+    
+    void append(Game &game){
+        if(game.getBoard().getRows()!=rows or game.getBoard().getCols()!=cols){
+            throw invalid_argument("game board does not match the move log");
+        }
+        const auto &history = game.getHistory();
+        append(history.data(),history.size(),movelog::resultOf(game));
+    }
+    
+    // games already encoded back to back, with the size of each
+    void appendEncoded(const vector<uint8_t> &games,const vector<uint32_t> &sizes){
+        uint64_t offset = written+buffer.size();
+        for(uint32_t size:sizes){
+            offsets.push_back(offset);
+            offset += size;
+        }
+        flushBuffer();
+        out.write((const char*)games.data(),games.size());
+        written += games.size();
+    }
+    
+    size_t getGameCount() const{
+        return offsets.size();
+    }
+    
+    void close(){
+        uint64_t indexOffset = written+buffer.size();
+        for(uint64_t offset:offsets) movelog::putU64(buffer,offset);
+        movelog::putU64(buffer,offsets.size());
+        movelog::putU64(buffer,indexOffset);
+        buffer.insert(buffer.end(),{'T','T','M','I'});
+        flushBuffer();
+        out.close();
+    }
+};
+
+// whole file in memory; game(i) is a direct seek through the index
+class MoveLogReader{
+    vector<uint8_t> data;
+    const uint8_t *index = nullptr;
+    uint64_t gameCount = 0;
+    int rows = 0, cols = 0, k = 0;
+    
+    public:
+    MoveLogReader(const string &path){
+        ifstream in(path,ios::binary|ios::ate);
+        if(!in) throw runtime_error("cannot open move log "+path);
+        data.resize((size_t)in.tellg());
+        in.seekg(0);
+        in.read((char*)data.data(),data.size());
+        if(data.size()<24 or memcmp(data.data(),"TTM1",4) or memcmp(data.data()+data.size()-4,"TTMI",4)){
+            throw runtime_error("not a move log: "+path);
+        }
+        const uint8_t *in8 = data.data()+4, *end = data.data()+data.size();
+        uint64_t shape[3];
+        for(auto &value:shape) value = movelog::getVarint(in8,end);
+        if(shape[0]>INT_MAX or shape[1]>INT_MAX or shape[2]>INT_MAX or !isValidShape(shape[0],shape[1],shape[2])){
+            throw runtime_error("corrupt move log");
+        }
+        rows = (int)shape[0];
+        cols = (int)shape[1];
+        k = (int)shape[2];
+        gameCount = movelog::getU64(end-20);
+        uint64_t indexOffset = movelog::getU64(end-12);
+        if(gameCount>data.size()/8 or indexOffset<4 or indexOffset+gameCount*8+20!=data.size()){
+            throw runtime_error("corrupt move log index: "+path);
+        }
+        index = data.data()+indexOffset;
+    }
+    
+    int getRows() const{ return rows; }
+    int getCols() const{ return cols; }
+    int getK() const{ return k; }
+    size_t size() const{ return gameCount; }
+    
+    // decodes game i into cells (reused across calls); offsets and counts
+    // come from the file, so each is checked before it is followed
+    GameResult readGame(size_t i,vector<uint16_t> &cells) const{
+        if(i>=gameCount) throw out_of_range("move log has no game "+to_string(i));
+        const uint8_t *end = index;
+        uint64_t offset = movelog::getU64(index+8*i);
+        if(offset<4 or offset>=(uint64_t)(end-data.data())) throw runtime_error("corrupt game offset in move log");
+        const uint8_t *in = data.data()+offset;
+        uint64_t count = movelog::getVarint(in,end);
+        // every move takes at least one byte after the result byte
+        if(in>=end or count>(uint64_t)(end-in-1)) throw runtime_error("truncated game in move log");
+        GameResult result = (GameResult)*in++;
+        cells.resize(count);
+        for(auto &cell:cells){
+            uint64_t value = movelog::getVarint(in,end);
+            if(value>=(uint64_t)rows*cols) throw runtime_error("corrupt cell in move log");
+            cell = (uint16_t)value;
+        }
+        return result;
+    }
+};
+
+struct ReplayStats{
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t mismatches = 0;    // illegal move, or result differs from the log
+};
+
+// re-plays logged games through Board + WinningStrategy to audit them;
+// threads take disjoint index ranges, each reusing one board
+class ReplayEngine{
+    int threads;
+    
+    // true while some k-line holds stones of at most one symbol, i.e.
+    // the game could still be won
+    static bool hasLiveLine(Board &board,const WinTable &wins){
+        const auto &grid = board.getGrid();
+        int cols = board.getCols();
+        for(int line=0;line<wins.lineCount();line++){
+            bool x = false, o = false;
+            for(int i=0;i<wins.k;i++){
+                int cell = wins.lineCells[line*wins.k+i];
+                Symbol symbol = grid[cell/cols][cell%cols];
+                x |= symbol==Symbol::X;
+                o |= symbol==Symbol::O;
+            }
+            if(!(x and o)) return true;
+        }
+        return false;
+    }
+    
+    static ReplayStats replayRange(const MoveLogReader &log,size_t from,size_t to){
+        ReplayStats stats;
+        Board board(log.getRows(),log.getCols());
+        KInARowWinningStrategy strategy(log.getK());
+        vector<uint16_t> cells;
+        int cols = log.getCols();
+        
+        for(size_t g=from;g<to;g++){
+            GameResult logged = log.readGame(g,cells);
+            board.clear();
+            strategy.reset();
+            GameResult replayed = UNFINISHED;
+            Symbol symbol = Symbol::X;
+            int played = 0;
+            for(uint16_t cell:cells){
+                int row = cell/cols, col = cell%cols;
+                if(replayed!=UNFINISHED or !board.canPlace(row,col)){
+                    replayed = UNFINISHED;
+                    played = -1;
+                    break;
+                }
+                board.place(row,col,symbol);
+                played++;
+                if(strategy.checkWinner(board,symbol,row,col)) replayed = symbol==Symbol::X ? X_WON : O_WON;
+                else if(strategy.isDraw(board,played)) replayed = DRAWN;
+                symbol = symbol==Symbol::X ? Symbol::O : Symbol::X;
+            }
+            stats.games++;
+            stats.moves += cells.size();
+            // a logged draw may come before the board is full, but only
+            // once no line can be completed; a cut-off log still has live lines
+            bool early = logged==DRAWN and replayed==UNFINISHED and played>=0 and
+                         !hasLiveLine(board,*WinTable::get(log.getRows(),log.getCols(),log.getK()));
+            if(played<0 or (replayed!=logged and !early)) stats.mismatches++;
+        }
+        return stats;
+    }
+    
+    public:
+    ReplayEngine(int threads = 1):threads(max(1,threads)){}
+    
+    // a corrupt game stops its thread; the first error is rethrown here
+    // once every thread has finished
+    ReplayStats replay(const MoveLogReader &log){
+        vector<ReplayStats> partial(threads);
+        vector<exception_ptr> errors(threads);
+        vector<thread> workers;
+        size_t per = (log.size()+threads-1)/threads;
+        for(int t=0;t<threads;t++){
+            size_t from = min(log.size(),t*per), to = min(log.size(),from+per);
+            workers.emplace_back([&partial,&errors,&log,t,from,to](){
+                try{
+                    partial[t] = replayRange(log,from,to);
+                }
+                catch(...){
+                    errors[t] = current_exception();
+                }
+            });
+        }
+        ReplayStats total;
+        for(int t=0;t<threads;t++){
+            workers[t].join();
+            total.games += partial[t].games;
+            total.moves += partial[t].moves;
+            total.mismatches += partial[t].mismatches;
+        }
+        for(auto &error:errors){
+            if(error) rethrow_exception(error);
+        }
+        return total;
+    }
+};
+
+// generates games in parallel and streams them to a move log. game g is
+// played with its own rng seeded from (seed, g), and chunks are written in
+// order, so the file is byte-identical for a seed whatever the thread count.
+// policy: take a winning cell, else block the opponent's, else random
+class SelfPlayDriver{
+    int rows, cols, k;
+    uint64_t seed;
+    int threads;
+    
+    static const size_t CHUNK = 4096;  // games per unit of work
+    
+    static uint64_t mix(uint64_t x){
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x^(x>>30))*0xbf58476d1ce4e5b9ull;
+        x = (x^(x>>27))*0x94d049bb133111ebull;
+        return x^(x>>31);
+    }
+    
+    void playGame(BitBoard &board,uint64_t game,vector<uint16_t> &cells,vector<int> &empty,GameResult &result) const{
+        mt19937_64 rng(mix(seed^mix(game)));
+        board.clear();
+        cells.clear();
+        empty.resize(rows*cols);
+        iota(empty.begin(),empty.end(),0);
+        result = DRAWN;
+        for(int player=0;!empty.empty();player^=1){
+            size_t pick = rng()%empty.size();
+            bool forced = false;
+            for(int side:{player,1-player}){
+                for(size_t i=0;i<empty.size() and !forced;i++){
+                    board.makeMove(empty[i],side);
+                    if(board.isWin(side,empty[i])){
+                        pick = i;
+                        forced = true;
+                    }
+                    board.undoMove(empty[i],side);
+                }
+            }
+            int cell = empty[pick];
+            empty[pick] = empty.back();
+            empty.pop_back();
+            board.makeMove(cell,player);
+            cells.push_back((uint16_t)cell);
+            if(board.isWin(player,cell)){
+                result = player==0 ? X_WON : O_WON;
+                break;
+            }
+        }
+    }
+    
+    public:
+    SelfPlayDriver(int rows,int cols,int k,uint64_t seed,int threads = 1):rows(rows),cols(cols),k(k),seed(seed),threads(max(1,threads)){}
+    
+    void generate(uint64_t games,const string &path){
+        MoveLogWriter writer(path,rows,cols,k);
+        size_t chunks = (games+CHUNK-1)/CHUNK;
+        struct Chunk{
+            vector<uint8_t> bytes;
+            vector<uint32_t> sizes;
+        };
+        mutex readyMutex;
+        condition_variable readyChanged;
+        map<size_t,Chunk> ready;
+        size_t nextToWrite = 0;
+        atomic<size_t> nextChunk{0};
+        
+        auto work = [&](){
+            BitBoard board(rows,cols,k);
+            vector<uint16_t> cells;
+            vector<int> empty;
+            GameResult result;
+            while(true){
+                size_t chunk = nextChunk++;
+                if(chunk>=chunks) return;
+                {
+                    // stay within a few chunks of the writer
+                    unique_lock<mutex> lock(readyMutex);
+                    readyChanged.wait(lock,[&](){ return chunk<nextToWrite+2*threads; });
+                }
+                Chunk encoded;
+                for(uint64_t g=chunk*CHUNK;g<min<uint64_t>(games,(chunk+1)*CHUNK);g++){
+                    playGame(board,g,cells,empty,result);
+                    size_t before = encoded.bytes.size();
+                    movelog::encodeGame(encoded.bytes,cells.data(),cells.size(),result);
+                    encoded.sizes.push_back((uint32_t)(encoded.bytes.size()-before));
+                }
+                lock_guard<mutex> lock(readyMutex);
+                ready[chunk] = move(encoded);
+                readyChanged.notify_all();
+            }
+        };
+        vector<thread> workers;
+        for(int t=0;t<threads;t++) workers.emplace_back(work);
         
+        while(true){
+            Chunk chunk;
+            {
+                unique_lock<mutex> lock(readyMutex);
+                readyChanged.wait(lock,[&](){ return nextToWrite==chunks or ready.count(nextToWrite); });
+                if(nextToWrite==chunks) break;
+                chunk = move(ready[nextToWrite]);
+                ready.erase(nextToWrite);
+            }
+            writer.appendEncoded(chunk.bytes,chunk.sizes);
+            lock_guard<mutex> lock(readyMutex);
+            nextToWrite++;
+            readyChanged.notify_all();
+        }
+        for(auto &worker:workers) worker.join();
+        writer.close();
+    }
+};
+
+
+/******************************************************************************
+Benchmark: ./a.out bench
+average checkWinner cost for random games on growing boards
+*******************************************************************************/
+
+// plays each move list as one game, returns ns per move (place + check);
+// board setup is not timed
+double timeGames(int size,WinningStrategy &strategy,const vector<vector<pair<int,int>>> &games){
+    long long moves = 0;
+    chrono::steady_clock::duration spent{0};
+    for(auto &game:games){
+        Board board(size);
+        strategy.reset();
+        auto start = chrono::steady_clock::now();
+        for(size_t m=0;m<game.size();m++){
+            Symbol symbol = m%2==0 ? Symbol::X : Symbol::O;
+            board.place(game[m].first,game[m].second,symbol);
+            moves++;
+            if(strategy.checkWinner(board,symbol,game[m].first,game[m].second)) break;
+        }
+        spent += chrono::steady_clock::now()-start;
+    }
+    return chrono::duration<double,nano>(spent).count()/moves;
+}
+
+void runWinCheckBenchmark(){
+    mt19937 rng(7);
+    for(int size:{3,19,101,1001}){
+        int count = size<=19 ? 2000 : size<=101 ? 20 : 1;
+        // random: shuffled cells. row fill: X fills row 2i while O fills
+        // row 2i+1, so rescans run along nearly complete lines
+        vector<vector<pair<int,int>>> random(count), rowFill(count);
+        for(int g=0;g<count;g++){
+            for(int r=0;r<size;r++) for(int c=0;c<size;c++) random[g].push_back({r,c});
+            shuffle(random[g].begin(),random[g].end(),rng);
+            for(int r=0;r+1<size;r+=2){
+                for(int c=0;c<size;c++){
+                    rowFill[g].push_back({r,(c+r)%size});
+                    rowFill[g].push_back({r+1,(c+r+1)%size});
+                }
+            }
+        }
+        for(auto workload:{&random,&rowFill}){
+            NXNWinningstrategy rescan;
+            CounterWinningStrategy counters;
+            KInARowWinningStrategy gomoku(5);
+            cout<<size<<"x"<<size<<(workload==&random ? " random:   " : " row fill: ")
+                <<"rescan "<<timeGames(size,rescan,*workload)
+                <<" ns, counters "<<timeGames(size,counters,*workload)
+                <<" ns, 5-in-a-row "<<timeGames(size,gomoku,*workload)<<" ns per move"<<endl;
+        }
+    }
+}
+
+
+// nodes/sec and time to a fixed depth per thread count, on a 15x15
+// gomoku middle game; speedup is against the single-threaded run
+void runSearchBenchmark(){
+    Board position(15);
+    int stones[][3] = {{7,7,0},{7,8,1},{8,8,0},{6,6,1},{8,7,0},{9,6,1},{6,8,0},{8,9,1}};
+    for(auto &stone:stones) position.place(stone[0],stone[1],stone[2]==0 ? Symbol::X : Symbol::O);
+    
+    unsigned hardware = max(1u,thread::hardware_concurrency());
+    cout<<"search: 15x15 k=5, "<<hardware<<" hardware threads"<<endl;
+    double baseRate = 0, baseTime = 0;
+    for(int threads:{1,2,4,8}){
+        SearchEngine timed(5);
+        SearchLimits budget{chrono::milliseconds(500)};
+        budget.threads = threads;
+        SearchResult byTime = timed.search(position,Symbol::X,budget);
         
+        SearchEngine fixed(5);
+        SearchLimits toDepth{chrono::milliseconds(60000)};
+        toDepth.threads = threads;
+        toDepth.maxDepth = 4;
+        SearchResult byDepth = fixed.search(position,Symbol::X,toDepth);
         
-        if(winningStrategy->checkWinner(board,currentPlayer.getSymbol(),row,col)){
-            cout<<"Player "<<currentPlayer.getName()<<" won"<<endl;
-            return;
+        double rate = byTime.nodesPerSecond(), seconds = byDepth.elapsed.count()/1e6;
+        if(threads==1){
+            baseRate = rate;
+            baseTime = seconds;
         }
-        if(movesPlayed==board.getSize() * board.getSize()){
-            cout<<"game draw:"<<endl;
-        }    
-        players.push(currentPlayer);
+        printf("  threads %d: %9.0f nodes/s (x%.2f), 500ms depth %d, depth 4 in %.3fs (x%.2f), move (%d, %d)\n",
+               threads,rate,rate/baseRate,byTime.depth,seconds,baseTime/seconds,byDepth.row,byDepth.col);
     }
+}
 
+// load generator: every session plays a seeded random game, one move in
+// flight per session; the sink submits a session's next move as soon as
+// the previous one is applied, so all sessions stay busy at once
+void runSessionBenchmark(int rows,int cols,int k,int sessions,int shards){
+    vector<vector<uint16_t>> orders(sessions);
+    mt19937 rng(42);
+    for(auto &order:orders){
+        for(int cell=0;cell<rows*cols;cell++) order.push_back(cell);
+        shuffle(order.begin(),order.end(),rng);
+    }
+    vector<uint64_t> ids(sessions);
+    vector<int> nextMove(sessions,0);
+    vector<vector<int64_t>> latencies(shards);
+    atomic<int> finished{0};
+    atomic<uint64_t> moves{0};
+    SessionServer *server = nullptr;
     
-};
+    auto submitNext = [&](int session){
+        uint16_t cell = orders[session][nextMove[session]++];
+        while(!server->submitMove(ids[session],cell/cols,cell%cols,session)) this_thread::yield();
+    };
+    
+    SessionServerConfig config;
+    config.shards = shards;
+    config.slotsPerShard = sessions/shards+1;
+    SessionServer instance(config,[&](const MoveEvent &event){
+        latencies[SessionServer::shardOf(event.session)].push_back(event.latency.count());
+        moves.fetch_add(1,memory_order_relaxed);
+        if(event.status==MoveStatus::OK) submitNext((int)event.tag);
+        else finished.fetch_add(1,memory_order_release);
+    });
+    server = &instance;
+    
+    auto start = chrono::steady_clock::now();
+    for(int i=0;i<sessions;i++) ids[i] = server->open(rows,cols,k);
+    for(int i=0;i<sessions;i++) submitNext(i);
+    while(finished.load()<sessions) this_thread::sleep_for(chrono::microseconds(200));
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    
+    vector<int64_t> all;
+    for(auto &shard:latencies) all.insert(all.end(),shard.begin(),shard.end());
+    sort(all.begin(),all.end());
+    printf("  %dx%d k=%d, %d sessions, %d shards: %.2fM moves/s, p50 %.1f us, p99 %.1f us, %zu live after\n",
+           rows,cols,k,sessions,shards,moves/seconds/1e6,all[all.size()/2]/1e3,all[all.size()*99/100]/1e3,server->liveSessions());
+}
 
+// self-play generation and replay throughput; the same seed is generated
+// with 1 and 4 threads and the two files must be identical
+void runMoveLogBenchmark(int rows,int cols,int k,uint64_t games){
+    string path = "/tmp/tictactoe_selfplay.bin", check = "/tmp/tictactoe_selfplay_1t.bin";
+    auto start = chrono::steady_clock::now();
+    SelfPlayDriver(rows,cols,k,2024,4).generate(games,path);
+    double generateSeconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    SelfPlayDriver(rows,cols,k,2024,1).generate(games,check);
+    
+    auto slurp = [](const string &file){
+        ifstream in(file,ios::binary);
+        return string(istreambuf_iterator<char>(in),istreambuf_iterator<char>());
+    };
+    string bytes = slurp(path);
+    bool identical = bytes==slurp(check);
+    
+    MoveLogReader log(path);
+    for(int threads:{1,4}){
+        start = chrono::steady_clock::now();
+        ReplayStats stats = ReplayEngine(threads).replay(log);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+        printf("  %dx%d k=%d: replay %d threads %.2fM games/s (%.1fM moves/s), %llu mismatches\n",
+               rows,cols,k,threads,stats.games/seconds/1e6,stats.moves/seconds/1e6,(unsigned long long)stats.mismatches);
+    }
+    printf("  %dx%d k=%d: self-play %.0f games/s on 4 threads, %.1f bytes/game, deterministic: %s\n",
+           rows,cols,k,games/generateSeconds,(double)bytes.size()/games,identical ? "yes" : "no");
+    remove(path.c_str());
+    remove(check.c_str());
+}
 
-int main()
+// benchmarks/ include this file for its classes and supply their own main
+#ifndef LLD_NO_MAIN
+int main(int argc, char** argv)
 {
+    if(argc==2 and string(argv[1])=="bench"){
+        runWinCheckBenchmark();
+        runSearchBenchmark();
+        cout<<"session server:"<<endl;
+        for(int shards:{1,2,4}){
+            runSessionBenchmark(3,3,3,20000,shards);
+            runSessionBenchmark(15,15,5,10000,shards);
+        }
+        cout<<"move logs:"<<endl;
+        runMoveLogBenchmark(3,3,3,1000000);
+        runMoveLogBenchmark(15,15,5,2000);
+        return 0;
+    }
+
     Player p1(Symbol::X, "Alice");
     Player p2(Symbol::O, "Bob");
 
@@ -173,6 +1751,82 @@ int main()
     game.playMove(0, 1); // Alice (X)
     game.playMove(2, 2); // Bob (O)
     game.playMove(0, 2); // Alice (X) -> WIN
+    
+    // same game, O(1) counters
+    CounterWinningStrategy counters;
+    Game fastGame(3, p1, p2, counters);
+    fastGame.playMove(0, 0);
+    fastGame.playMove(1, 1);
+    fastGame.playMove(0, 1);
+    fastGame.playMove(2, 2);
+    fastGame.playMove(0, 2);
+    
+    // every line blocked after 8 moves -> draw without filling the board
+    Game drawnGame(3, p1, p2, counters);
+    int drawMoves[8][2] = {{0,0},{0,1},{0,2},{1,0},{1,1},{2,0},{2,1},{2,2}};
+    for(auto &m:drawMoves) drawnGame.playMove(m[0], m[1]);
+    
+    // gomoku: 5 in a row on 15 x 15
+    KInARowWinningStrategy gomoku(5);
+    Game gomokuGame(15, 15, p1, p2, gomoku);
+    for(int i=0;i<5;i++){
+        gomokuGame.playMove(7, 3+i);    // Alice
+        if(i<4) gomokuGame.playMove(8, 3+i);  // Bob
+    }
+    
+    // AI: perfect play from an empty 3x3 board is a draw
+    SearchEngine engine(3);
+    Board empty(3);
+    SearchResult solved = engine.search(empty, Symbol::X, chrono::milliseconds(500));
+    cout<<"3x3 solved: score "<<solved.score<<" at depth "<<solved.depth<<", "<<solved.nodes<<" nodes"<<endl;
+    
+    // hint: X to move must block O's column
+    Game hintGame(3, p1, p2, counters);
+    hintGame.playMove(0, 0);
+    hintGame.playMove(0, 1);
+    hintGame.playMove(2, 2);
+    hintGame.playMove(1, 1);
+    SearchResult hint = hintGame.hint(engine, SearchLimits{chrono::milliseconds(100)});
+    cout<<"hint for Alice: ("<<hint.row<<", "<<hint.col<<")"<<endl;
+    
+    // AI vs AI on gomoku, 50ms per move on two search threads
+    SearchEngine gomokuEngine(5);
+    Game aiGame(15, 15, p1, p2, gomoku);
+    SearchLimits aiLimits{chrono::milliseconds(50)};
+    aiLimits.threads = 2;
+    for(int i=0;i<12;i++){
+        SearchResult move = aiGame.playComputerMove(gomokuEngine, aiLimits);
+        if(i==0) cout<<"gomoku opening ("<<move.row<<", "<<move.col<<"), depth "<<move.depth<<endl;
+    }
+    
+    // move log: record the AI game, read it back and audit it
+    {
+        MoveLogWriter writer("/tmp/tictactoe_demo.bin", 15, 15, 5);
+        writer.append(aiGame);
+        writer.close();
+        MoveLogReader log("/tmp/tictactoe_demo.bin");
+        ReplayStats replayed = ReplayEngine().replay(log);
+        cout<<"logged "<<log.size()<<" game, "<<replayed.moves<<" moves, "<<replayed.mismatches<<" replay mismatches"<<endl;
+        remove("/tmp/tictactoe_demo.bin");
+    }
+    
+    // session server: results come back as events, the finished game is evicted
+    {
+        mutex printMutex;
+        SessionServer server(SessionServerConfig{}, [&](const MoveEvent &event){
+            lock_guard<mutex> lock(printMutex);
+            cout<<"session "<<hex<<event.session<<dec;
+            if(event.type==SessionEventType::UNKNOWN_SESSION) cout<<" unknown (never issued or already evicted)"<<endl;
+            else cout<<" move "<<event.moveNumber<<" ("<<event.row<<", "<<event.col<<") status "<<(int)event.status<<endl;
+        });
+        uint64_t session = server.open(3, 3, 3);
+        int moves[][2] = {{0,0},{1,1},{0,1},{2,2},{0,2},{1,0}};
+        for(auto &move:moves) server.submitMove(session, move[0], move[1]);
+        server.submitMove(0xffffffffffffffffull, 0, 0);    // no such shard or slot
+        server.shutdown();
+        cout<<"live sessions: "<<server.liveSessions()<<endl;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -4,14 +4,159 @@ traffic signal design using state design pattern
 
 *******************************************************************************/
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 using namespace std;
 
+enum class Phase : uint8_t { RED, GREEN, YELLOW };
+
+// phase that follows each phase, indexed by Phase
+constexpr array<Phase, 3> NEXT_PHASE = {Phase::GREEN, Phase::YELLOW, Phase::RED};
+
+constexpr Phase nextPhase(Phase phase) {
+    return NEXT_PHASE[static_cast<int>(phase)];
+}
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::RED: return "RED";
+        case Phase::GREEN: return "GREEN";
+        case Phase::YELLOW: return "YELLOW";
+    }
+    return "?";
+}
+
+// ---- Timing ----
+
+// phase lengths in simulated seconds. the signal enters RED at
+// offset + n * cycle and runs RED -> GREEN -> YELLOW
+struct SignalTiming {
+    uint32_t red = 30;
+    uint32_t green = 25;
+    uint32_t yellow = 5;
+    uint32_t offset = 0;
+
+    uint32_t cycle() const { return red + green + yellow; }
+
+    uint32_t duration(Phase phase) const {
+        return phase == Phase::RED ? red : phase == Phase::GREEN ? green : yellow;
+    }
+};
+
+// phase a signal is in at simulated time t, and how long until it changes
+struct PhaseAt {
+    Phase phase;
+    uint32_t remaining;
+};
+
+PhaseAt phaseAt(const SignalTiming& timing, uint64_t t) {
+    uint32_t cycle = timing.cycle();
+    uint32_t position = (t + cycle - timing.offset % cycle) % cycle;
+    if (position < timing.red) return {Phase::RED, timing.red - position};
+    if (position < timing.red + timing.green) return {Phase::GREEN, timing.red + timing.green - position};
+    return {Phase::YELLOW, cycle - position};
+}
+
+// ---- Signal bank ----
+
+// phases of many signals in flat arrays: state[i] packs the seconds left in
+// the current phase (high bits) with the phase (low 2 bits), durations are
+// one array per phase. tick() steps every signal one second in a single
+// branch-free loop the compiler can vectorize; nothing is allocated after
+// add(), and there is no object or vtable per signal
+class SignalBank {
+    vector<uint32_t> state;
+    vector<uint16_t> red, green, yellow;
+    uint64_t now = 0;
+
+    static uint32_t pack(Phase phase, uint32_t remaining) {
+        return remaining << 2 | static_cast<uint32_t>(phase);
+    }
+
+public:
+    uint32_t add(const SignalTiming& timing) { return add(timing, now); }
+
+    // starts the signal in the phase its offset gives at time `at`, for
+    // owners that keep their own clock instead of calling tick()
+    uint32_t add(const SignalTiming& timing, uint64_t at) {
+        if (timing.red == 0 || timing.green == 0 || timing.yellow == 0 || timing.cycle() > UINT16_MAX) {
+            throw invalid_argument("phase durations must be 1..65535 seconds");
+        }
+        PhaseAt start = phaseAt(timing, at);
+        state.push_back(pack(start.phase, start.remaining));
+        red.push_back(timing.red);
+        green.push_back(timing.green);
+        yellow.push_back(timing.yellow);
+        return state.size() - 1;
+    }
+
+    Phase phase(uint32_t id) const { return static_cast<Phase>(state[id] & 3); }
+    uint32_t remaining(uint32_t id) const { return state[id] >> 2; }
+    size_t size() const { return state.size(); }
+    uint64_t time() const { return now; }
+
+    uint32_t duration(uint32_t id, Phase phase) const {
+        return phase == Phase::RED ? red[id] : phase == Phase::GREEN ? green[id] : yellow[id];
+    }
+
+    // jumps one signal to `phase` with that phase's full duration
+    void setPhase(uint32_t id, Phase phase) {
+        state[id] = pack(phase, duration(id, phase));
+    }
+
+    // moves one signal on to its next phase now
+    void advance(uint32_t id) {
+        setPhase(id, nextPhase(this->phase(id)));
+    }
+
+    // one simulated second for every signal
+    void tick() {
+        uint32_t* s = state.data();
+        const uint16_t* r = red.data();
+        const uint16_t* g = green.data();
+        const uint16_t* y = yellow.data();
+        size_t n = state.size();
+        // the table is unrolled into compile-time constants and every select
+        // is a mask, so the loop body has no branches and no lookups
+        constexpr uint32_t afterRed = static_cast<uint32_t>(nextPhase(Phase::RED));
+        constexpr uint32_t afterGreen = static_cast<uint32_t>(nextPhase(Phase::GREEN));
+        constexpr uint32_t afterYellow = static_cast<uint32_t>(nextPhase(Phase::YELLOW));
+        for (size_t i = 0; i < n; i++) {
+            uint32_t current = s[i] - 4;
+            uint32_t phase = current & 3;
+            uint32_t next = (afterRed & -uint32_t(phase == 0)) | (afterGreen & -uint32_t(phase == 1)) |
+                            (afterYellow & -uint32_t(phase == 2));
+            uint32_t length = (r[i] & -uint32_t(next == 0)) | (g[i] & -uint32_t(next == 1)) | (y[i] & -uint32_t(next == 2));
+            uint32_t expired = -uint32_t(current < 4);
+            s[i] = (current & ~expired) | ((length << 2 | next) & expired);
+        }
+        now++;
+    }
+
+    void tick(uint32_t seconds) {
+        for (uint32_t i = 0; i < seconds; i++) tick();
+    }
+};
+
 class TrafficSignal;  
 
 // State Interface
 class TrafficSignalState {
 public:
     virtual void handle(TrafficSignal* light) = 0;
+    virtual Phase phase() const = 0;
+    virtual const char* message() const = 0;
     virtual ~TrafficSignalState() = default;
 };
 
@@ -20,25 +165,39 @@ class RedState;
 class GreenState;
 class YellowState;
 
-// Context
+// states hold no data, so one shared instance of each is enough
+TrafficSignalState* stateFor(Phase phase);
+
+// Context: a facade over one slot of a SignalBank. a default constructed
+// signal owns a one-slot bank; bank signals are views into a shared bank
 class TrafficSignal {
 private:
-    TrafficSignalState* currentState;
+    unique_ptr<SignalBank> owned;
+    SignalBank* bank;
+    uint32_t id;
+    bool announce = true;   // print each phase message on request()
 
 public:
     TrafficSignal();
+    TrafficSignal(SignalBank& bank, uint32_t id) : bank(&bank), id(id), announce(false) {}
 
+    // states are shared singletons: nothing to free
     void setState(TrafficSignalState* state) {
-        delete currentState;
-        currentState = state;
+        bank->setPhase(id, state->phase());
     }
 
     void request() {
+        TrafficSignalState* currentState = stateFor(getPhase());
+        if (announce) cout << currentState->message() << "\n";
         currentState->handle(this);
     }
 
-    ~TrafficSignal() {
-        delete currentState;
+    Phase getPhase() const {
+        return bank->phase(id);
+    }
+
+    void setAnnounce(bool enabled) {
+        announce = enabled;
     }
 };
 
@@ -47,46 +206,537 @@ public:
 class RedState : public TrafficSignalState {
 public:
     void handle(TrafficSignal* light) override;
+    Phase phase() const override { return Phase::RED; }
+    const char* message() const override { return "Red Light - Stop 🚫"; }
 };
 
 class GreenState : public TrafficSignalState {
 public:
     void handle(TrafficSignal* light) override;
+    Phase phase() const override { return Phase::GREEN; }
+    const char* message() const override { return "Green Light - Go ✅"; }
 };
 
 class YellowState : public TrafficSignalState {
 public:
     void handle(TrafficSignal* light) override;
+    Phase phase() const override { return Phase::YELLOW; }
+    const char* message() const override { return "Yellow Light - Slow Down ⚠️"; }
 };
 
 // ---- Now define all handle methods AFTER full class definitions ----
 
 void RedState::handle(TrafficSignal* light) {
-    cout << "Red Light - Stop 🚫\n";
-    light->setState(new GreenState());
+    light->setState(stateFor(nextPhase(Phase::RED)));
 }
 
 void GreenState::handle(TrafficSignal* light) {
-    cout << "Green Light - Go ✅\n";
-    light->setState(new YellowState());
+    light->setState(stateFor(nextPhase(Phase::GREEN)));
 }
 
 void YellowState::handle(TrafficSignal* light) {
-    cout << "Yellow Light - Slow Down ⚠️\n";
-    light->setState(new RedState());
+    light->setState(stateFor(nextPhase(Phase::YELLOW)));
+}
+
+TrafficSignalState* stateFor(Phase phase) {
+    static RedState red;
+    static GreenState green;
+    static YellowState yellow;
+    switch (phase) {
+        case Phase::RED: return &red;
+        case Phase::GREEN: return &green;
+        case Phase::YELLOW: return &yellow;
+    }
+    return &red;
 }
 
 // Constructor
-TrafficSignal::TrafficSignal() {
-    currentState = new RedState();
+TrafficSignal::TrafficSignal() : owned(new SignalBank()), bank(owned.get()) {
+    id = bank->add(SignalTiming{});
+    bank->setPhase(id, Phase::RED);
+}
+
+// ---- Hierarchical timer wheel ----
+
+// 4 levels of 256 one-second slots cover 2^32 seconds ahead. a timer sits in
+// the lowest level whose slot span still contains its due time and moves
+// down a level when the level above wraps onto its slot. timers are
+// intrusive lists over ids, so scheduling never allocates. each pending id
+// remembers its slot; cancelling walks that one slot's list, which keeps the
+// per-event path as cheap as a plain singly linked list.
+class TimerWheel {
+    static constexpr int LEVELS = 4;
+    static constexpr int BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << BITS;
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint16_t IDLE = UINT16_MAX;
+
+    array<array<uint32_t, SLOTS>, LEVELS> heads;
+    vector<uint32_t> next;
+    vector<uint16_t> slot;      // level * SLOTS + index while pending, IDLE otherwise
+    vector<uint64_t> due;
+    uint64_t now = 0;
+
+    uint32_t& headOf(uint16_t where) { return heads[where / SLOTS][where % SLOTS]; }
+
+    void place(uint32_t id) {
+        uint64_t differs = due[id] ^ now;
+        int level = 0;
+        while (level < LEVELS - 1 && (differs >> (BITS * (level + 1))) != 0) level++;
+        slot[id] = level * SLOTS + ((due[id] >> (BITS * level)) & (SLOTS - 1));
+        uint32_t& head = headOf(slot[id]);
+        next[id] = head;
+        head = id;
+    }
+
+    void unlink(uint32_t id) {
+        uint32_t* link = &headOf(slot[id]);
+        while (*link != id) link = &next[*link];
+        *link = next[id];
+        slot[id] = IDLE;
+    }
+
+    void cascade(int level) {
+        uint32_t& head = heads[level][(now >> (BITS * level)) & (SLOTS - 1)];
+        uint32_t id = head;
+        head = NIL;
+        while (id != NIL) {
+            uint32_t following = next[id];
+            place(id);
+            id = following;
+        }
+    }
+
+public:
+    TimerWheel() {
+        for (auto& level : heads) level.fill(NIL);
+    }
+
+    uint64_t time() const { return now; }
+
+    // at most one pending timer per id: scheduling a pending id moves it.
+    // time must not be in the past
+    void schedule(uint32_t id, uint64_t time) {
+        if (id >= next.size()) {
+            next.resize(id + 1, NIL);
+            slot.resize(id + 1, IDLE);
+            due.resize(id + 1, 0);
+        }
+        if (slot[id] != IDLE) unlink(id);
+        due[id] = time;
+        place(id);
+    }
+
+    void cancel(uint32_t id) {
+        if (id < slot.size() && slot[id] != IDLE) unlink(id);
+    }
+
+    // fires every timer due before `until`, in time order; fire(id, time)
+    // may schedule or cancel any timer, including ones due this second
+    template <typename Fire>
+    void advance(uint64_t until, Fire&& fire) {
+        while (now < until) {
+            uint32_t& head = heads[0][now & (SLOTS - 1)];
+            while (head != NIL) {
+                uint32_t id = head;
+                head = next[id];
+                slot[id] = IDLE;
+                fire(id, now);
+            }
+            now++;
+            for (int level = LEVELS - 1; level > 0; level--) {
+                if ((now & ((1ull << (BITS * level)) - 1)) == 0) cascade(level);
+            }
+        }
+    }
+};
+
+// ---- Discrete-event simulation ----
+
+struct SignalTraceEvent {
+    uint64_t time;
+    uint32_t signal;
+    Phase phase;    // phase entered
+};
+
+// drives many signals off one timer wheel: each signal has exactly one
+// pending event, its next phase change. simulated time only jumps through
+// the wheel, so a run goes as fast as events can be handled. phases live in
+// a SignalBank; tracing is per signal and off by default
+class SignalSimulation {
+    SignalBank bank;
+    vector<uint8_t> traced;
+    TimerWheel wheel;
+    function<void(const SignalTraceEvent&)> traceSink;
+    uint64_t events = 0;
+
+public:
+    explicit SignalSimulation(function<void(const SignalTraceEvent&)> sink = nullptr)
+        : traceSink(move(sink)) {}
+
+    // signals start in the phase their offset gives at the current time;
+    // the bank is never ticked here, the wheel holds the clock
+    uint32_t addSignal(const SignalTiming& timing) {
+        uint32_t id = bank.add(timing, wheel.time());
+        traced.push_back(0);
+        wheel.schedule(id, wheel.time() + bank.remaining(id));
+        return id;
+    }
+
+    void setTracing(uint32_t id, bool enabled) {
+        traced[id] = enabled;
+    }
+
+    // processes every phase change before time `until`
+    void runUntil(uint64_t until) {
+        wheel.advance(until, [this](uint32_t id, uint64_t now) {
+            bank.advance(id);
+            Phase phase = bank.phase(id);
+            wheel.schedule(id, now + bank.remaining(id));
+            events++;
+            if (traced[id] && traceSink) traceSink({now, id, phase});
+        });
+    }
+
+    uint64_t now() const { return wheel.time(); }
+    uint64_t eventsProcessed() const { return events; }
+    size_t size() const { return bank.size(); }
+
+    Phase phase(uint32_t id) const { return bank.phase(id); }
+
+    // the classic request(): the signal moves on to its next phase now and
+    // its pending change is rescheduled from there. phase changes must go
+    // through here, a TrafficSignal view of the bank would leave the wheel
+    // firing at the old time
+    void request(uint32_t id) {
+        bank.advance(id);
+        wheel.schedule(id, wheel.time() + bank.remaining(id));
+        if (traced[id] && traceSink) traceSink({wheel.time(), id, bank.phase(id)});
+    }
+};
+
+// ---- Corridor timing ----
+
+// a one-way arterial: vehicles enter at signal 0 and at every side street,
+// and drive downstream through every later signal. travelTime[i] is the
+// free-flow time from signal i to i+1
+struct Corridor {
+    vector<uint32_t> travelTime;    // size signals - 1
+    double entryRate = 0.15;        // vehicles per second at signal 0
+    vector<double> sideRate;        // vehicles per second joining at each signal
+    double saturationFlow = 1.0;    // vehicles per green second leaving a queue (two lanes)
+    uint32_t yellow = 4;
+
+    size_t signals() const { return sideRate.size(); }
+};
+
+// one shared cycle length, a green time and an offset per signal; red is
+// whatever the cycle has left after green and yellow
+struct TimingPlan {
+    uint32_t cycle = 0;
+    vector<uint32_t> green;
+    vector<uint32_t> offset;
+
+    SignalTiming timing(size_t i, uint32_t yellow) const {
+        return SignalTiming{cycle - green[i] - yellow, green[i], yellow, offset[i]};
+    }
+};
+
+struct PlanScore {
+    double averageDelay = 0;    // queued seconds per vehicle
+    uint64_t vehicles = 0;
+};
+
+// second-by-second queue model: vehicles wait in a queue at each signal,
+// leave at the saturation flow while it is green, then arrive at the next
+// queue after the link travel time. arrivals are drawn once from the seed,
+// so every plan is scored against the same traffic
+class CorridorSimulator {
+    Corridor corridor;
+    uint32_t horizon;
+    vector<vector<uint8_t>> arrivals;   // [signal][second]
+    uint32_t maxTravel = 0;
+
+public:
+    CorridorSimulator(const Corridor& corridor, uint32_t horizon, uint64_t seed)
+        : corridor(corridor), horizon(horizon), arrivals(corridor.signals(), vector<uint8_t>(horizon)) {
+        mt19937_64 rng(seed);
+        for (size_t i = 0; i < corridor.signals(); i++) {
+            double rate = corridor.sideRate[i] + (i == 0 ? corridor.entryRate : 0);
+            poisson_distribution<int> perSecond(rate);
+            for (auto& count : arrivals[i]) count = perSecond(rng);
+        }
+        for (uint32_t travel : corridor.travelTime) maxTravel = max(maxTravel, travel);
+    }
+
+    const Corridor& getCorridor() const { return corridor; }
+
+    PlanScore evaluate(const TimingPlan& plan) const {
+        size_t n = corridor.signals();
+        SignalBank bank;
+        for (size_t i = 0; i < n; i++) bank.add(plan.timing(i, corridor.yellow));
+
+        // in-flight vehicles per link, bucketed by arrival second
+        uint32_t ring = maxTravel + 1;
+        vector<uint32_t> inFlight(n * ring, 0);
+        vector<uint32_t> queue(n, 0);
+        vector<double> credit(n, 0);
+        uint64_t waited = 0, vehicles = 0;
+
+        for (uint32_t t = 0; t < horizon; t++) {
+            for (size_t i = 0; i < n; i++) {
+                uint32_t& landing = inFlight[i * ring + t % ring];
+                queue[i] += arrivals[i][t] + landing;
+                vehicles += arrivals[i][t];
+                landing = 0;
+
+                if (bank.phase(i) == Phase::GREEN) {
+                    credit[i] = min(credit[i] + corridor.saturationFlow, 1.0 + corridor.saturationFlow);
+                    uint32_t leaving = min<uint32_t>(queue[i], credit[i]);
+                    credit[i] -= leaving;
+                    queue[i] -= leaving;
+                    if (i + 1 < n) inFlight[(i + 1) * ring + (t + corridor.travelTime[i]) % ring] += leaving;
+                } else {
+                    credit[i] = 0;
+                }
+                waited += queue[i];
+            }
+            bank.tick();
+        }
+        return PlanScore{vehicles ? (double)waited / vehicles : 0, vehicles};
+    }
+};
+
+struct OptimizationResult {
+    TimingPlan best;
+    PlanScore bestScore;
+    PlanScore greenWaveScore;   // starting point: offsets from travel times
+    uint64_t plansEvaluated = 0;
+    double seconds = 0;
+};
+
+// random search in rounds: the first round samples whole plans, later
+// rounds perturb the best plan so far with shrinking steps. each round's
+// plans are scored in parallel; plan j of a round is generated from
+// (seed, round, j) and ties go to the lowest index, so the result depends
+// only on the seed, never on the thread count
+class TimingOptimizer {
+    const CorridorSimulator& simulator;
+    uint32_t minCycle, maxCycle;
+    uint64_t seed;
+    int threads;
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // green starts exactly when the platoon from signal 0 arrives
+    TimingPlan greenWave(uint32_t cycle) const {
+        const Corridor& corridor = simulator.getCorridor();
+        TimingPlan plan;
+        plan.cycle = cycle;
+        uint32_t arrival = 0;
+        for (size_t i = 0; i < corridor.signals(); i++) {
+            uint32_t green = (cycle - corridor.yellow) / 2;
+            uint32_t red = cycle - green - corridor.yellow;
+            plan.green.push_back(green);
+            plan.offset.push_back((arrival % cycle + 2 * cycle - red) % cycle);
+            if (i + 1 < corridor.signals()) arrival += corridor.travelTime[i];
+        }
+        return plan;
+    }
+
+    void clampGreens(TimingPlan& plan) const {
+        uint32_t yellow = simulator.getCorridor().yellow;
+        for (auto& green : plan.green) green = max<uint32_t>(5, min(green, plan.cycle - yellow - 5));
+    }
+
+    TimingPlan randomPlan(mt19937_64& rng) const {
+        TimingPlan plan;
+        plan.cycle = minCycle + rng() % (maxCycle - minCycle + 1);
+        for (size_t i = 0; i < simulator.getCorridor().signals(); i++) {
+            plan.green.push_back(rng() % plan.cycle);
+            plan.offset.push_back(rng() % plan.cycle);
+        }
+        clampGreens(plan);
+        return plan;
+    }
+
+    TimingPlan perturb(const TimingPlan& base, uint32_t step, mt19937_64& rng) const {
+        TimingPlan plan = base;
+        auto jitter = [&]() { return (int)(rng() % (2 * step + 1)) - (int)step; };
+        if (rng() % 4 == 0) plan.cycle = max<int>(minCycle, min<int>(maxCycle, (int)plan.cycle + jitter()));
+        for (size_t i = 0; i < plan.green.size(); i++) {
+            plan.green[i] = max(0, (int)plan.green[i] + jitter());
+            plan.offset[i] = ((int)plan.offset[i] + jitter() + 2 * (int)plan.cycle) % plan.cycle;
+        }
+        clampGreens(plan);
+        return plan;
+    }
+
+public:
+    TimingOptimizer(const CorridorSimulator& simulator, uint32_t minCycle, uint32_t maxCycle, uint64_t seed,
+                    int threads = 1)
+        : simulator(simulator), minCycle(minCycle), maxCycle(maxCycle), seed(seed), threads(max(1, threads)) {
+        if (minCycle < simulator.getCorridor().yellow + 10 || maxCycle < minCycle) {
+            throw invalid_argument("cycle range too short for green + yellow + red");
+        }
+    }
+
+    OptimizationResult optimize(uint32_t plansPerRound, uint32_t rounds) {
+        auto start = chrono::steady_clock::now();
+        OptimizationResult result;
+        result.best = greenWave((minCycle + maxCycle) / 2);
+        result.bestScore = result.greenWaveScore = simulator.evaluate(result.best);
+        result.plansEvaluated = 1;
+
+        vector<TimingPlan> plans(plansPerRound);
+        vector<PlanScore> scores(plansPerRound);
+        for (uint32_t round = 0; round < rounds; round++) {
+            uint32_t step = max<uint32_t>(1, maxCycle >> (round + 1));
+            atomic<uint32_t> next{0};
+            auto work = [&]() {
+                for (uint32_t j = next++; j < plansPerRound; j = next++) {
+                    mt19937_64 rng(mix(seed ^ mix((uint64_t)round << 32 | j)));
+                    plans[j] = round == 0 ? randomPlan(rng) : perturb(result.best, step, rng);
+                    scores[j] = simulator.evaluate(plans[j]);
+                }
+            };
+            vector<thread> workers;
+            for (int t = 1; t < threads; t++) workers.emplace_back(work);
+            work();
+            for (auto& worker : workers) worker.join();
+
+            for (uint32_t j = 0; j < plansPerRound; j++) {
+                if (scores[j].averageDelay < result.bestScore.averageDelay) {
+                    result.best = plans[j];
+                    result.bestScore = scores[j];
+                }
+            }
+            result.plansEvaluated += plansPerRound;
+        }
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+// ---- Benchmark: ./a.out bench ----
+
+SignalTiming randomTiming(mt19937& rng) {
+    SignalTiming timing;
+    timing.red = 20 + rng() % 40;
+    timing.green = 20 + rng() % 40;
+    timing.yellow = 3 + rng() % 3;
+    timing.offset = rng() % timing.cycle();
+    return timing;
 }
 
-int main() {
+void runSimulationBenchmark(uint32_t signalCount, uint64_t seconds) {
+    mt19937 rng(1);
+    SignalSimulation simulation;
+    for (uint32_t i = 0; i < signalCount; i++) simulation.addSignal(randomTiming(rng));
+
+    auto start = chrono::steady_clock::now();
+    simulation.runUntil(seconds);
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%u signals, %.1f simulated hours: %llu events in %.2fs, %.1fM events/s, %.0fx real time\n",
+           signalCount, seconds / 3600.0, (unsigned long long)simulation.eventsProcessed(), wall,
+           simulation.eventsProcessed() / wall / 1e6, seconds / wall);
+}
+
+// fixed-step sweep: every signal advanced every simulated second. the
+// event-driven run of the same bank is the cross-check
+void runSweepBenchmark(uint32_t signalCount, uint32_t seconds) {
+    mt19937 rng(1);
+    SignalBank bank;
+    SignalSimulation simulation;
+    for (uint32_t i = 0; i < signalCount; i++) {
+        SignalTiming timing = randomTiming(rng);
+        bank.add(timing);
+        simulation.addSignal(timing);
+    }
+
+    auto start = chrono::steady_clock::now();
+    bank.tick(seconds);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // a phase change due exactly at `seconds` is already applied by tick()
+    simulation.runUntil(seconds + 1);
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < signalCount; i++) {
+        mismatches += bank.phase(i) != simulation.phase(i);
+    }
+    printf("%u signals x %u ticks: %.1fM signal steps/ms, %u phase mismatches vs event run\n",
+           signalCount, seconds, (double)signalCount * seconds / ms / 1e6, mismatches);
+}
+
+Corridor sampleCorridor(size_t signals) {
+    Corridor corridor;
+    mt19937 rng(3);
+    for (size_t i = 0; i + 1 < signals; i++) corridor.travelTime.push_back(15 + rng() % 30);
+    for (size_t i = 0; i < signals; i++) corridor.sideRate.push_back(0.005 + (rng() % 4) * 0.005);
+    return corridor;
+}
+
+// plans/sec per thread count on a 12-signal corridor; the best plan must
+// be the same for every thread count
+void runOptimizerBenchmark() {
+    CorridorSimulator simulator(sampleCorridor(12), 3600, 11);
+    double baseRate = 0;
+    double firstDelay = -1;
+    for (int threads : {1, 2, 4, 8}) {
+        OptimizationResult result = TimingOptimizer(simulator, 40, 120, 5, threads).optimize(1000, 4);
+        double rate = result.plansEvaluated / result.seconds;
+        if (threads == 1) baseRate = rate;
+        if (firstDelay < 0) firstDelay = result.bestScore.averageDelay;
+        printf("optimizer %d threads: %.0f plans/s (x%.2f), best delay %.2fs vs green wave %.2fs, cycle %us, %s\n",
+               threads, rate, rate / baseRate, result.bestScore.averageDelay, result.greenWaveScore.averageDelay,
+               result.best.cycle, result.bestScore.averageDelay == firstDelay ? "same plan" : "DIFFERENT plan");
+    }
+}
+
+// benchmarks/ include this file for its classes and supply their own main
+#ifndef LLD_NO_MAIN
+int main(int argc, char** argv) {
+    if (argc == 2 && string(argv[1]) == "bench") {
+        runSimulationBenchmark(1000, 86400);
+        runSimulationBenchmark(100000, 86400);
+        runSweepBenchmark(1000000, 600);
+        runSweepBenchmark(4000000, 100);
+        runOptimizerBenchmark();
+        return 0;
+    }
+
     TrafficSignal signal;
 
     for (int i = 0; i < 6; i++) {
         signal.request();
     }
 
+    // two signals on a shared clock, the second one traced
+    SignalSimulation simulation([](const SignalTraceEvent& event) {
+        cout << "t=" << event.time << "s signal " << event.signal << " -> " << phaseName(event.phase) << "\n";
+    });
+    simulation.addSignal(SignalTiming{30, 25, 5, 0});
+    uint32_t traced = simulation.addSignal(SignalTiming{30, 25, 5, 20});
+    simulation.setTracing(traced, true);
+    simulation.runUntil(180);
+    // an early request: the traced signal changes now, later changes shift with it
+    simulation.request(traced);
+    simulation.runUntil(240);
+    cout << simulation.eventsProcessed() << " phase changes in " << simulation.now() << " simulated seconds\n";
+
+    // green-wave tuning for a 5-signal corridor over one simulated hour
+    CorridorSimulator corridor(sampleCorridor(5), 3600, 1);
+    OptimizationResult tuned = TimingOptimizer(corridor, 40, 120, 7, 2).optimize(200, 3);
+    cout << "corridor: green wave delay " << tuned.greenWaveScore.averageDelay << "s, tuned "
+         << tuned.bestScore.averageDelay << "s with a " << tuned.best.cycle << "s cycle, offsets";
+    for (uint32_t offset : tuned.best.offset) cout << " " << offset;
+    cout << "\n";
+
     return 0;
 }
+#endif